@@ -101,6 +101,7 @@ int main() {
     printf("Expected: %d total increments\n", NUM_THREADS * ITERATIONS);
     printf("\nRun with: make perf-03\n");
     printf("Look for cache-misses and LLC-load-misses\n");
+    printf("Or: make fsdetect-03 (flags the packed counters' cache line)\n");
     
     free(packed_counters);
     free(aligned_counters);
@@ -5,6 +5,7 @@
  * - Test-and-set (TAS) spinlock
  * - Test-and-test-and-set (TTAS) spinlock  
  * - Compare with pthread_spinlock_t
+ * - Flat combining: one lock hand-off serves many threads' requests
  * 
  * Learn why TTAS is better for contention.
  */
@@ -15,6 +16,8 @@
 #include <stdatomic.h>   // C11 atomics (lock-free ops + memory orders)
 #include <stdbool.h>
 #include "benchmark.h"
+#include "lock_workload.h"  // CS_LINES / THINK_NS knobs (default 0 = bare counter)
+#include "flat_combining.h" // Publish requests, one combiner runs them all
 
 #define NUM_THREADS 4
 #define ITERATIONS 100000
@@ -154,7 +157,9 @@ void *tas_worker(void *arg) {
     for (int i = 0; i < ITERATIONS; i++) {
         tas_lock(lock);
         shared_counter++;
+        cs_work(CS_LINES);
         tas_unlock(lock);
+        think_ns(THINK_NS);
     }
     return NULL;
 }
@@ -164,7 +169,9 @@ void *ttas_worker(void *arg) {
     for (int i = 0; i < ITERATIONS; i++) {
         ttas_lock(lock);
         shared_counter++;
+        cs_work(CS_LINES);
         ttas_unlock(lock);
+        think_ns(THINK_NS);
     }
     return NULL;
 }
@@ -174,7 +181,9 @@ void *pthread_spin_worker(void *arg) {
     for (int i = 0; i < ITERATIONS; i++) {
         pthread_spin_lock(lock);
         shared_counter++;
+        cs_work(CS_LINES);
         pthread_spin_unlock(lock);
+        think_ns(THINK_NS);
     }
     return NULL;
 }
@@ -184,7 +193,9 @@ void *ttas_pause_worker(void *arg) {
     for (int i = 0; i < ITERATIONS; i++) {
         ttas_pause_lock(lock);
         shared_counter++;
+        cs_work(CS_LINES);
         ttas_pause_unlock(lock);
+        think_ns(THINK_NS);
     }
     return NULL;
 }
@@ -194,7 +205,28 @@ void *backoff_worker(void *arg) {
     for (int i = 0; i < ITERATIONS; i++) {
         backoff_lock(lock);
         shared_counter++;
+        cs_work(CS_LINES);
         backoff_unlock(lock);
+        think_ns(THINK_NS);
+    }
+    return NULL;
+}
+
+// Flat combining: the critical section becomes an op that a combiner runs
+static fc_lock_t fc_lock;
+
+static long fc_counter_op(void *state, long arg) {
+    (void)state;
+    shared_counter += arg;
+    cs_work(CS_LINES);
+    return 0;
+}
+
+void *fc_worker(void *arg) {
+    int tid = (int)(long)arg;
+    for (int i = 0; i < ITERATIONS; i++) {
+        fc_apply(&fc_lock, tid, fc_counter_op, 1);
+        think_ns(THINK_NS);
     }
     return NULL;
 }
@@ -205,6 +237,8 @@ int main() {
     printf("═══════════════════════════════════════════════════════════\n");
     printf("  Exercise 05: Spinlock Internals & CPU Instructions\n");
     printf("  Threads: %d, Iterations: %d\n", NUM_THREADS, ITERATIONS);
+    printf("  Critical section: %d cache lines, think time: %dns\n",
+           CS_LINES, THINK_NS);
     printf("═══════════════════════════════════════════════════════════\n\n");
 
     // // Test 1: TAS spinlock
@@ -301,6 +335,25 @@ int main() {
 
     // pthread_spin_destroy(&pthread_lock);
 
+    // Test 6: Flat combining
+    printf("\n6. Flat combining (include/flat_combining.h)\n");
+    fc_init(&fc_lock, NULL);
+    shared_counter = 0;
+
+    TIME_BLOCK("   Flat combining") {
+        for (long i = 0; i < NUM_THREADS; i++) {
+            pthread_create(&threads[i], NULL, fc_worker, (void *)i);
+        }
+        for (int i = 0; i < NUM_THREADS; i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    printf("   Counter: %ld %s\n", shared_counter,
+           shared_counter == (long)NUM_THREADS * ITERATIONS ? "✓" : "✗");
+    printf("   Requests per combiner pass: %.2f\n", fc_batch_size(&fc_lock));
+    printf("   How: Post request in own padded slot; lock holder runs all\n");
+    printf("   Benefit: Counter stays in one cache, waiters spin locally\n\n");
+
     // printf("═══════════════════════════════════════════════════════════\n");
     // printf("  KEY INSIGHTS:\n");
     // printf("  • TAS: Every spin = atomic op = cache coherency traffic\n");
@@ -28,6 +28,7 @@
 #include <stdbool.h>
 #include <unistd.h>
 #include "benchmark.h"
+#include "lock_workload.h"  // cs_work(), think_ns(), CS_LINES, THINK_NS
 
 #define NUM_THREADS 8
 #define INCREMENTS 2000000
@@ -56,7 +57,16 @@ static void* variant_a_worker(void* arg) {
     // TODO: For each iteration:
     //   1. Acquire the lock
     //   2. Increment shared_counter
-    //   3. Release the lock
+    //   3. cs_work(CS_LINES)  - extra shared cache lines touched under the lock
+    //   4. Release the lock
+    //   5. think_ns(THINK_NS) - non-critical work before the next acquire
+    // Both knobs default to 0 (100% contention). Rebuild with e.g.
+    //   make -B 08_summary EXTRA_CFLAGS="-DCS_LINES=4 -DTHINK_NS=200"
+    // and see whether your lock choice still wins (exercise 12 has the matrix)
+    //
+    // ADVANCED: replace lock/increment/unlock with flat combining
+    //   fc_apply(&fc, tid, fc_op_add, 1);   // include "flat_combining.h"
+    // Pass the thread index as arg; fc_init(&fc, &shared_counter) first
 
     (void)arg;
     return NULL;
@@ -73,6 +83,8 @@ static void run_variant_a(void) {
 
     printf("═══════════════════════════════════════════════════════════\n");
     printf("Variant A: Shared counter with synchronization\n");
+    printf("  Critical section: %d cache lines, think time: %dns\n",
+           CS_LINES, THINK_NS);
 
     TIME_BLOCK("Variant A: synchronized counter") {
         // TODO: Create NUM_THREADS threads running variant_a_worker
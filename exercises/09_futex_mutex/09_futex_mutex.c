@@ -0,0 +1,223 @@
+/**
+ * Exercise 09: Futex Mutex - Spin, Then Park
+ *
+ * Exercise 05 compared spinlocks with each other. Real services mostly use a
+ * BLOCKING lock, because critical sections can be long and threads often
+ * outnumber cores. This exercise builds one from scratch (include/futex.h):
+ *
+ *   state 0 = unlocked, 1 = locked, 2 = locked + maybe waiters
+ *
+ *   lock:   CAS 0->1 (fast path) → adaptive spin → XCHG 2 + FUTEX_WAIT
+ *   unlock: XCHG 0, FUTEX_WAKE only if the old state was 2
+ *
+ * and benchmarks it against pthread_mutex_t and the exercise 05 spinlocks at
+ * 1x and 4x oversubscription (threads = cores, threads = 4 * cores).
+ *
+ * LEARNING GOALS:
+ * - Why a 3-state word lets unlock skip the syscall when nobody sleeps
+ * - Why spinlocks collapse when the lock holder gets preempted
+ * - How much CPU each strategy burns while waiting (user+sys time)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "benchmark.h"
+#include "spinlock.h"
+#include "futex.h"
+
+#define TOTAL_ACQUIRES 400000  // Split across threads: every run does equal work
+#define CS_PAUSES 16           // Work inside the critical section (PAUSEs)
+#define OVERSUBSCRIPTION 4
+
+static long shared_counter = 0;
+static atomic_int start_flag = 0;
+static int iterations_per_thread = 0;
+
+static inline void critical_section(void) {
+    shared_counter++;
+    for (int i = 0; i < CS_PAUSES; i++) {
+        CPU_PAUSE();
+    }
+}
+
+static inline void wait_for_start(void) {
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+}
+
+// ============================================================================
+// Workers (one per lock type, same shape as exercise 05)
+// ============================================================================
+
+void *tas_worker(void *arg) {
+    tas_spinlock_t *lock = arg;
+    wait_for_start();
+    for (int i = 0; i < iterations_per_thread; i++) {
+        tas_lock(lock);
+        critical_section();
+        tas_unlock(lock);
+    }
+    return NULL;
+}
+
+void *ttas_worker(void *arg) {
+    ttas_spinlock_t *lock = arg;
+    wait_for_start();
+    for (int i = 0; i < iterations_per_thread; i++) {
+        ttas_lock(lock);
+        critical_section();
+        ttas_unlock(lock);
+    }
+    return NULL;
+}
+
+void *backoff_worker(void *arg) {
+    backoff_spinlock_t *lock = arg;
+    wait_for_start();
+    for (int i = 0; i < iterations_per_thread; i++) {
+        backoff_lock(lock);
+        critical_section();
+        backoff_unlock(lock);
+    }
+    return NULL;
+}
+
+void *pthread_spin_worker(void *arg) {
+    pthread_spinlock_t *lock = arg;
+    wait_for_start();
+    for (int i = 0; i < iterations_per_thread; i++) {
+        pthread_spin_lock(lock);
+        critical_section();
+        pthread_spin_unlock(lock);
+    }
+    return NULL;
+}
+
+void *pthread_mutex_worker(void *arg) {
+    pthread_mutex_t *lock = arg;
+    wait_for_start();
+    for (int i = 0; i < iterations_per_thread; i++) {
+        pthread_mutex_lock(lock);
+        critical_section();
+        pthread_mutex_unlock(lock);
+    }
+    return NULL;
+}
+
+void *futex_worker(void *arg) {
+    futex_mutex_t *lock = arg;
+    wait_for_start();
+    for (int i = 0; i < iterations_per_thread; i++) {
+        futex_mutex_lock(lock);
+        critical_section();
+        futex_mutex_unlock(lock);
+    }
+    return NULL;
+}
+
+// ============================================================================
+// Benchmark driver
+// ============================================================================
+
+static double cpu_seconds(const struct rusage *ru) {
+    return ru->ru_utime.tv_sec + ru->ru_utime.tv_usec / 1e6 +
+           ru->ru_stime.tv_sec + ru->ru_stime.tv_usec / 1e6;
+}
+
+static void run_bench(const char *label, void *(*worker)(void *), void *lock,
+                      int nthreads) {
+    pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+    struct rusage ru_start, ru_end;
+
+    shared_counter = 0;
+    iterations_per_thread = TOTAL_ACQUIRES / nthreads;
+    atomic_store(&start_flag, 0);
+
+    for (int i = 0; i < nthreads; i++) {
+        pthread_create(&threads[i], NULL, worker, lock);
+    }
+
+    getrusage(RUSAGE_SELF, &ru_start);
+    uint64_t start = get_nanos();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    uint64_t elapsed = get_nanos() - start;
+    getrusage(RUSAGE_SELF, &ru_end);
+
+    long expected = (long)iterations_per_thread * nthreads;
+    printf("   %-16s %9.2f ms %8.2f Mops/s  cpu %7.2f ms  vol-csw %7ld  %s\n",
+           label, elapsed / 1e6, expected / (elapsed / 1e3),
+           (cpu_seconds(&ru_end) - cpu_seconds(&ru_start)) * 1000,
+           ru_end.ru_nvcsw - ru_start.ru_nvcsw,
+           shared_counter == expected ? "✓" : "✗ INCORRECT");
+
+    free(threads);
+}
+
+static void run_suite(int nthreads) {
+    tas_spinlock_t tas = TAS_SPINLOCK_INITIALIZER;
+    ttas_spinlock_t ttas = TTAS_SPINLOCK_INITIALIZER;
+    backoff_spinlock_t backoff = BACKOFF_SPINLOCK_INITIALIZER;
+    pthread_spinlock_t pspin;
+    pthread_mutex_t pmutex = PTHREAD_MUTEX_INITIALIZER;
+    futex_mutex_t fmutex = FUTEX_MUTEX_INITIALIZER;
+
+    pthread_spin_init(&pspin, PTHREAD_PROCESS_PRIVATE);
+
+    run_bench("TAS", tas_worker, &tas, nthreads);
+    run_bench("TTAS", ttas_worker, &ttas, nthreads);
+    run_bench("Backoff", backoff_worker, &backoff, nthreads);
+    run_bench("pthread_spin", pthread_spin_worker, (void *)&pspin, nthreads);
+    run_bench("pthread_mutex", pthread_mutex_worker, &pmutex, nthreads);
+    run_bench("futex_mutex", futex_worker, &fmutex, nthreads);
+
+    int budget = atomic_load(&fmutex.spin_estimate) * 2 + FUTEX_SPIN_MIN;
+    printf("   (futex_mutex learned spin budget: %d pauses)\n\n",
+           budget > FUTEX_SPIN_MAX ? FUTEX_SPIN_MAX : budget);
+
+    pthread_spin_destroy(&pspin);
+    pthread_mutex_destroy(&pmutex);
+}
+
+int main() {
+    int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) ncpu = 1;
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 09: Futex Mutex - Spin, Then Park\n");
+    printf("  CPUs: %d, Total acquires per run: %d, CS: %d pauses\n",
+           ncpu, TOTAL_ACQUIRES, CS_PAUSES);
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    printf("1. 1x subscription (%d threads = cores)\n", ncpu);
+    run_suite(ncpu);
+
+    printf("2. %dx oversubscription (%d threads)\n",
+           OVERSUBSCRIPTION, ncpu * OVERSUBSCRIPTION);
+    run_suite(ncpu * OVERSUBSCRIPTION);
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • Uncontended futex lock/unlock = one CAS + one XCHG, no syscall\n");
+    printf("  • State 2 means 'maybe sleepers': unlock wakes only then\n");
+    printf("  • Oversubscribed spinlocks spin while the holder is descheduled\n");
+    printf("    (watch cpu time explode vs wall time)\n");
+    printf("  • Spin-then-park gets spinlock latency for short holds and\n");
+    printf("    mutex efficiency for long ones\n");
+    printf("\n");
+    printf("  ANALYSIS COMMANDS:\n");
+    printf("  make perf-09    - Compare context-switches per lock\n");
+    printf("  make asm-09     - Find 'lock cmpxchg', 'xchg' and 'syscall'\n");
+    printf("  strace -f -c -e futex ./exercises/09_futex_mutex/09_futex_mutex\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    return 0;
+}
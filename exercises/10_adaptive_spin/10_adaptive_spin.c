@@ -0,0 +1,255 @@
+/**
+ * Exercise 10: Adaptive Spinning - Learn the Hold Time
+ *
+ * backoff_lock() from exercise 05 uses fixed BACKOFF_MIN/BACKOFF_MAX. That is
+ * right for one workload and wrong for the rest:
+ * - Short critical sections: spinning wins, parking costs a syscall + wakeup
+ * - Long critical sections: spinning burns a whole core for nothing
+ * - Bimodal: most holds are short, a few are very long
+ *
+ * adaptive_lock_t (include/adaptive_lock.h) measures its own hold time and
+ * spin success rate and tunes, per lock instance at runtime, how long to spin
+ * and whether to spin at all before parking on a futex.
+ *
+ * Each workload runs in ROUNDS rounds so you can watch the adaptive lock
+ * converge (avg hold, spin budget, success rate) next to the fixed lock.
+ * A final run switches one lock from long to short holds and checks that
+ * it learns to spin again.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "benchmark.h"
+#include "spinlock.h"
+#include "adaptive_lock.h"
+
+#define NUM_THREADS 4
+#define ROUNDS 5
+#define THINK_NS 500     // Non-critical work between acquisitions
+#define RECOVERY_LONG_ROUNDS 2
+
+typedef struct {
+    const char *name;
+    uint64_t short_ns;      // Typical hold time
+    uint64_t long_ns;       // Rare hold time
+    int long_per_mille;     // How often the long hold happens (0..1000)
+    int acquires_per_round; // Total across all threads
+} workload_t;
+
+static const workload_t workloads[] = {
+    { "short (200ns)",          200,    200,    0, 100000 },
+    { "long (50us)",          50000,  50000,    0,   1000 },
+    { "bimodal (200ns/100us)",  200, 100000,   50,  10000 },
+};
+
+typedef struct {
+    void *lock;
+    const workload_t *w;
+    int iterations;
+    uint32_t seed;
+} worker_arg_t;
+
+static long shared_counter = 0;
+static atomic_int start_flag = 0;
+
+static inline void busy_ns(uint64_t ns) {
+    uint64_t end = get_nanos() + ns;
+    while (get_nanos() < end) {
+        CPU_PAUSE();
+    }
+}
+
+static inline uint64_t hold_time(worker_arg_t *a) {
+    if (a->w->long_per_mille > 0 &&
+        (int)(xorshift32(&a->seed) % 1000) < a->w->long_per_mille) {
+        return a->w->long_ns;
+    }
+    return a->w->short_ns;
+}
+
+static inline void wait_for_start(void) {
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+}
+
+void *backoff_worker(void *arg) {
+    worker_arg_t *a = arg;
+    backoff_spinlock_t *lock = a->lock;
+    wait_for_start();
+    for (int i = 0; i < a->iterations; i++) {
+        uint64_t hold = hold_time(a);
+        backoff_lock(lock);
+        shared_counter++;
+        busy_ns(hold);
+        backoff_unlock(lock);
+        busy_ns(THINK_NS);
+    }
+    return NULL;
+}
+
+void *adaptive_worker(void *arg) {
+    worker_arg_t *a = arg;
+    adaptive_lock_t *lock = a->lock;
+    wait_for_start();
+    for (int i = 0; i < a->iterations; i++) {
+        uint64_t hold = hold_time(a);
+        adaptive_lock(lock);
+        shared_counter++;
+        busy_ns(hold);
+        adaptive_unlock(lock);
+        busy_ns(THINK_NS);
+    }
+    return NULL;
+}
+
+static double cpu_seconds(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+           ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+/**
+ * Run one round; returns wall time in ms and stores CPU time in *cpu_ms
+ */
+static double run_round(void *(*worker)(void *), void *lock,
+                        const workload_t *w, double *cpu_ms) {
+    pthread_t threads[NUM_THREADS];
+    worker_arg_t args[NUM_THREADS];
+    int iterations = w->acquires_per_round / NUM_THREADS;
+
+    shared_counter = 0;
+    atomic_store(&start_flag, 0);
+    for (int i = 0; i < NUM_THREADS; i++) {
+        args[i] = (worker_arg_t){ lock, w, iterations, 0x9e3779b9u * (i + 1) };
+        pthread_create(&threads[i], NULL, worker, &args[i]);
+    }
+
+    double cpu_start = cpu_seconds();
+    uint64_t start = get_nanos();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double wall_ms = (get_nanos() - start) / 1e6;
+    *cpu_ms = (cpu_seconds() - cpu_start) * 1000;
+
+    if (shared_counter != (long)iterations * NUM_THREADS) {
+        printf("   ✗ INCORRECT counter: %ld\n", shared_counter);
+    }
+    return wall_ms;
+}
+
+static void run_workload(const workload_t *w) {
+    backoff_spinlock_t backoff = BACKOFF_SPINLOCK_INITIALIZER;
+    adaptive_lock_t adaptive;
+    adaptive_lock_init(&adaptive);
+
+    printf("Workload: %s, %d acquires/round, think %dns\n",
+           w->name, w->acquires_per_round, THINK_NS);
+    printf("   round | backoff wall/cpu ms | adaptive wall/cpu ms |"
+           " avg hold  budget  spin-ok | spin-wins parks\n");
+
+    for (int r = 0; r < ROUNDS; r++) {
+        double b_cpu, a_cpu;
+        double b_wall = run_round(backoff_worker, &backoff, w, &b_cpu);
+        unsigned long wins0 = atomic_load(&adaptive.spin_wins);
+        unsigned long parks0 = atomic_load(&adaptive.parks);
+        double a_wall = run_round(adaptive_worker, &adaptive, w, &a_cpu);
+
+        printf("   %5d | %8.1f / %8.1f | %8.1f / %8.1f  | %6luns %6luns %6.1f%% | %9lu %5lu\n",
+               r + 1, b_wall, b_cpu, a_wall, a_cpu,
+               (unsigned long)atomic_load(&adaptive.avg_hold_ns),
+               (unsigned long)adaptive_spin_budget(&adaptive, 0),
+               atomic_load(&adaptive.spin_success) * 100.0 / ADAPT_SUCCESS_ONE,
+               atomic_load(&adaptive.spin_wins) - wins0,
+               atomic_load(&adaptive.parks) - parks0);
+    }
+    printf("\n");
+}
+
+/**
+ * Long holds teach the lock to park at once; when holds turn short again,
+ * probes must win and bring spinning back. Returns false if they never do
+ */
+static bool run_recovery(long ncpus) {
+    adaptive_lock_t adaptive;
+    adaptive_lock_init(&adaptive);
+    const workload_t *long_w = &workloads[1], *short_w = &workloads[0];
+    double cpu_ms;
+
+    printf("Recovery: %s for %d rounds, then %s on the same lock\n",
+           long_w->name, RECOVERY_LONG_ROUNDS, short_w->name);
+    for (int r = 0; r < RECOVERY_LONG_ROUNDS; r++) {
+        run_round(adaptive_worker, &adaptive, long_w, &cpu_ms);
+    }
+    printf("   after long: budget %luns, spin-ok %.1f%%\n",
+           (unsigned long)adaptive_spin_budget(&adaptive, 0),
+           atomic_load(&adaptive.spin_success) * 100.0 / ADAPT_SUCCESS_ONE);
+
+    printf("   round | avg hold  budget  spin-ok | spin-wins parks\n");
+    uint64_t budget = 0;
+    unsigned long wins = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        unsigned long wins0 = atomic_load(&adaptive.spin_wins);
+        unsigned long parks0 = atomic_load(&adaptive.parks);
+        run_round(adaptive_worker, &adaptive, short_w, &cpu_ms);
+        budget = adaptive_spin_budget(&adaptive, 0);
+        wins = atomic_load(&adaptive.spin_wins) - wins0;
+        printf("   %5d | %6luns %6luns %6.1f%% | %9lu %5lu\n", r + 1,
+               (unsigned long)atomic_load(&adaptive.avg_hold_ns), (unsigned long)budget,
+               atomic_load(&adaptive.spin_success) * 100.0 / ADAPT_SUCCESS_ONE,
+               wins, atomic_load(&adaptive.parks) - parks0);
+    }
+
+    if (ncpus < 2) {
+        printf("   (skipped: needs 2+ CPUs - here no spin can ever win)\n\n");
+        return true;
+    }
+    bool ok = budget > 0 && wins > 0;
+    if (ok) {
+        printf("   ✓ Short holds spin again after the long phase\n\n");
+    } else {
+        printf("   ✗ INCORRECT: still parking immediately after %d short rounds\n\n", ROUNDS);
+    }
+    return ok;
+}
+
+int main() {
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 10: Adaptive Spinning - Learn the Hold Time\n");
+    printf("  Threads: %d, Rounds: %d, Fixed backoff: %d..%d pauses\n",
+           NUM_THREADS, ROUNDS, BACKOFF_MIN, BACKOFF_MAX);
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    for (size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+        run_workload(&workloads[i]);
+    }
+    run_recovery(sysconf(_SC_NPROCESSORS_ONLN));
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • budget = %dx avg hold, clamped to %d..%dns\n",
+           ADAPT_SPIN_FACTOR, ADAPT_SPIN_MIN_NS, ADAPT_SPIN_MAX_NS);
+    printf("  • avg hold > %dns or spin success < %d%% → park immediately\n",
+           ADAPT_PARK_NS, ADAPT_MIN_SUCCESS * 100 / ADAPT_SUCCESS_ONE);
+    printf("  • Short holds: spins win, no syscalls (like TTAS)\n");
+    printf("  • Long holds: parks at once, cpu time ≈ wall time / threads\n");
+    printf("  • Bimodal: success rate decides; probes keep the estimate fresh\n");
+    printf("  • Fewer cores than threads: spinning never wins (holder can't\n");
+    printf("    run while you spin) - the success rate learns that too\n");
+    printf("\n");
+    printf("  ANALYSIS:\n");
+    printf("  make perf-10    - Context switches: backoff vs adaptive\n");
+    printf("  strace -f -c -e futex ./exercises/10_adaptive_spin/10_adaptive_spin\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    return 0;
+}
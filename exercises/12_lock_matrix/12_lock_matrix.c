@@ -0,0 +1,224 @@
+/**
+ * Exercise 12: Lock Crossover Matrix
+ *
+ * Exercises 05 and 08 hammer a lock with a bare shared_counter++ back to
+ * back: 100% contention, zero work. Which lock wins there says little about
+ * which lock wins in real code. This exercise sweeps the two things that
+ * actually decide it:
+ *
+ *   threads          - how many compete (vs how many CPUs you have!)
+ *   CS length        - cache lines of shared data written under the lock
+ *
+ * with a fixed think time (non-critical work) between acquisitions, and
+ * prints a throughput matrix per lock plus the winner of every cell. Look
+ * for the crossovers:
+ * - spin vs park:    spinlocks win short CS on idle cores, futex/adaptive
+ *                    win once threads > CPUs or the CS gets long
+ * - simple vs queue: TAS/TTAS win at low thread counts, ticket/MCS keep
+ *                    hand-off cost flat as waiters pile up (until preempted)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <unistd.h>
+#ifndef THINK_NS
+#define THINK_NS 200     // Non-critical work between acquisitions
+#endif
+
+#include "benchmark.h"
+#include "spinlock.h"
+#include "futex.h"
+#include "adaptive_lock.h"
+#include "lock_workload.h"
+
+#define CELL_MS 20       // Measurement time per (lock, threads, CS) cell
+#define MAX_THREADS 16
+
+static const int thread_counts[] = { 1, 2, 4, 8 };
+static const int cs_lengths[] = { 0, 1, 4, 16, 64 };  // Cache lines
+
+#define NUM_T (int)(sizeof(thread_counts) / sizeof(thread_counts[0]))
+#define NUM_CS (int)(sizeof(cs_lengths) / sizeof(cs_lengths[0]))
+
+typedef struct {
+    CACHE_ALIGNED mcs_node_t node;  // Only used by the MCS worker
+    int cs_lines;
+    long ops;
+} worker_arg_t;
+
+static long shared_counter = 0;
+static atomic_int start_flag = 0;
+static atomic_int stop_flag = 0;
+
+static tas_spinlock_t tas = TAS_SPINLOCK_INITIALIZER;
+static ttas_spinlock_t ttas = TTAS_SPINLOCK_INITIALIZER;
+static backoff_spinlock_t backoff = BACKOFF_SPINLOCK_INITIALIZER;
+static ticket_spinlock_t ticket = TICKET_SPINLOCK_INITIALIZER;
+static mcs_lock_t mcs = MCS_LOCK_INITIALIZER;
+static pthread_spinlock_t pspin;
+static pthread_mutex_t pmutex = PTHREAD_MUTEX_INITIALIZER;
+static futex_mutex_t fmutex = FUTEX_MUTEX_INITIALIZER;
+static adaptive_lock_t adaptive;
+
+// ============================================================================
+// Workers: one per lock type so every lock call is inlined
+// ============================================================================
+
+#define DEFINE_WORKER(name, lock_expr, unlock_expr)                         \
+    void *name##_worker(void *arg) {                                        \
+        worker_arg_t *a = arg;                                              \
+        long ops = 0;                                                       \
+        while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {  \
+            CPU_PAUSE();                                                    \
+        }                                                                   \
+        while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {   \
+            lock_expr;                                                      \
+            shared_counter++;                                               \
+            cs_work(a->cs_lines);                                           \
+            unlock_expr;                                                    \
+            think_ns(THINK_NS);                                             \
+            ops++;                                                          \
+        }                                                                   \
+        a->ops = ops;                                                       \
+        return NULL;                                                        \
+    }
+
+DEFINE_WORKER(tas, tas_lock(&tas), tas_unlock(&tas))
+DEFINE_WORKER(ttas, ttas_lock(&ttas), ttas_unlock(&ttas))
+DEFINE_WORKER(backoff, backoff_lock(&backoff), backoff_unlock(&backoff))
+DEFINE_WORKER(ticket, ticket_lock(&ticket), ticket_unlock(&ticket))
+DEFINE_WORKER(mcs, mcs_lock(&mcs, &a->node), mcs_unlock(&mcs, &a->node))
+DEFINE_WORKER(pspin, pthread_spin_lock(&pspin), pthread_spin_unlock(&pspin))
+DEFINE_WORKER(pmutex, pthread_mutex_lock(&pmutex), pthread_mutex_unlock(&pmutex))
+DEFINE_WORKER(futex, futex_mutex_lock(&fmutex), futex_mutex_unlock(&fmutex))
+DEFINE_WORKER(adaptive, adaptive_lock(&adaptive), adaptive_unlock(&adaptive))
+
+typedef struct {
+    const char *name;
+    void *(*worker)(void *);
+} lock_variant_t;
+
+static const lock_variant_t variants[] = {
+    { "TAS",           tas_worker },
+    { "TTAS",          ttas_worker },
+    { "Backoff",       backoff_worker },
+    { "Ticket",        ticket_worker },
+    { "MCS",           mcs_worker },
+    { "pthread_spin",  pspin_worker },
+    { "pthread_mutex", pmutex_worker },
+    { "futex_mutex",   futex_worker },
+    { "adaptive",      adaptive_worker },
+};
+
+#define NUM_VARIANTS (int)(sizeof(variants) / sizeof(variants[0]))
+
+/**
+ * Run one cell for CELL_MS; returns throughput in Mops/s
+ */
+static double run_cell(void *(*worker)(void *), int nthreads, int cs_lines) {
+    pthread_t threads[MAX_THREADS];
+    worker_arg_t *args = cache_aligned_alloc(sizeof(worker_arg_t) * nthreads);
+
+    shared_counter = 0;
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int i = 0; i < nthreads; i++) {
+        args[i].cs_lines = cs_lines;
+        args[i].ops = 0;
+        pthread_create(&threads[i], NULL, worker, &args[i]);
+    }
+
+    uint64_t start = get_nanos();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    usleep(CELL_MS * 1000);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+
+    long total = 0;
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+        total += args[i].ops;
+    }
+    uint64_t elapsed = get_nanos() - start;
+    free(args);
+
+    if (shared_counter != total) {
+        printf("   ✗ INCORRECT counter: %ld (expected %ld)\n", shared_counter, total);
+    }
+    return total * 1e3 / elapsed;
+}
+
+int main() {
+    static double results[NUM_VARIANTS][NUM_T][NUM_CS];
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 12: Lock Crossover Matrix\n");
+    printf("  CPUs: %ld, think time: %dns, %dms per cell\n",
+           ncpu, THINK_NS, CELL_MS);
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    pthread_spin_init(&pspin, PTHREAD_PROCESS_PRIVATE);
+    adaptive_lock_init(&adaptive);
+
+    for (int v = 0; v < NUM_VARIANTS; v++) {
+        printf("%s - throughput (Mops/s)\n", variants[v].name);
+        printf("   threads \\ CS lines");
+        for (int c = 0; c < NUM_CS; c++) {
+            printf(" %8d", cs_lengths[c]);
+        }
+        printf("\n");
+        for (int t = 0; t < NUM_T; t++) {
+            printf("   %7d%s         ", thread_counts[t],
+                   thread_counts[t] > ncpu ? "*" : " ");
+            for (int c = 0; c < NUM_CS; c++) {
+                results[v][t][c] = run_cell(variants[v].worker,
+                                            thread_counts[t], cs_lengths[c]);
+                printf(" %8.2f", results[v][t][c]);
+                fflush(stdout);
+            }
+            printf("\n");
+        }
+        printf("\n");
+    }
+
+    printf("Winner per cell (* = more threads than CPUs)\n");
+    printf("   threads \\ CS lines");
+    for (int c = 0; c < NUM_CS; c++) {
+        printf(" %13d", cs_lengths[c]);
+    }
+    printf("\n");
+    for (int t = 0; t < NUM_T; t++) {
+        printf("   %7d%s         ", thread_counts[t],
+               thread_counts[t] > ncpu ? "*" : " ");
+        for (int c = 0; c < NUM_CS; c++) {
+            int best = 0;
+            for (int v = 1; v < NUM_VARIANTS; v++) {
+                if (results[v][t][c] > results[best][t][c]) best = v;
+            }
+            printf(" %13s", variants[best].name);
+        }
+        printf("\n");
+    }
+
+    printf("\n═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • 1 thread = uncontended cost: the cheapest fast path wins\n");
+    printf("  • Longer CS: lock overhead amortizes, the gap between locks\n");
+    printf("    shrinks - until waiters burn the CPU the holder needs\n");
+    printf("  • threads > CPUs (*): spinners steal the holder's timeslice;\n");
+    printf("    parking locks (futex, pthread_mutex, adaptive) pull ahead\n");
+    printf("  • Ticket/MCS are FIFO: a preempted waiter blocks everyone\n");
+    printf("    behind it, so oversubscribed queue locks collapse hardest\n");
+    printf("  • Pick a lock for YOUR cell, not for the 0-line/max-thread one\n");
+    printf("\n");
+    printf("  KNOBS:\n");
+    printf("  make -B run-12 EXTRA_CFLAGS=\"-DTHINK_NS=1000\"\n");
+    printf("  make -B run-05 EXTRA_CFLAGS=\"-DCS_LINES=4 -DTHINK_NS=200\"\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    pthread_spin_destroy(&pspin);
+    return 0;
+}
@@ -0,0 +1,273 @@
+/**
+ * Exercise 14: Delegation - Ship the Code, Not the Data
+ *
+ * Every lock in exercise 05 (and MCS in exercise 12) moves the protected
+ * data into the cache of whoever holds the lock next. For a structure that
+ * all cores hammer, that migration IS the critical section's cost.
+ *
+ * include/delegation.h (ffwd-style) pins the data to one server thread:
+ * clients write {fn, arg} into their own request line, the server runs the
+ * calls and writes results back in batched response lines. The data never
+ * moves; only two small lines per client do.
+ *
+ * Two shared structures, delegation vs the exercise 05 spinlocks (+ MCS):
+ * - a shared counter
+ * - a small hash table (64 one-cache-line buckets, 80% lookups)
+ *
+ * NOTE: the server is an extra thread that needs its own core. With fewer
+ * cores than clients + 1, it time-shares with them and loses - run this on
+ * a multi-core box to see the real picture.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <unistd.h>
+#include "benchmark.h"
+#include "spinlock.h"
+#include "delegation.h"
+#include "lock_workload.h"
+
+#define CELL_MS 50       // Measurement time per (method, threads) cell
+#define MAX_THREADS 16
+
+static const int thread_counts[] = { 1, 2, 4, 8 };
+#define NUM_T (int)(sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+// ============================================================================
+// Shared structures (sequential code - the lock/server makes them safe)
+// ============================================================================
+
+#define HT_BUCKETS 64
+#define HT_WAYS 7        // 7 keys + 7 values + count = one cache line
+#define HT_KEYS (HT_BUCKETS * HT_WAYS)  // key % 64 never overflows a bucket
+
+typedef struct {
+    CACHE_ALIGNED int keys[HT_WAYS];
+    int values[HT_WAYS];
+    int count;
+} ht_bucket_t;
+
+enum { HT_LOOKUP, HT_INSERT, HT_DELETE };
+
+static ht_bucket_t table[HT_BUCKETS];
+static long shared_counter = 0;
+
+static long counter_op(void *state, long arg) {
+    (void)state;
+    shared_counter += arg;
+    return shared_counter;
+}
+
+// arg = key << 2 | op; returns 1 if the key was found/inserted/deleted
+static long ht_op(void *state, long arg) {
+    (void)state;
+    int key = (int)(arg >> 2);
+    ht_bucket_t *b = &table[key % HT_BUCKETS];
+    for (int i = 0; i < b->count; i++) {
+        if (b->keys[i] == key) {
+            switch (arg & 3) {
+            case HT_LOOKUP: return 1;
+            case HT_INSERT: b->values[i]++; return 0;
+            default:        // Delete: move the last entry into the hole
+                b->count--;
+                b->keys[i] = b->keys[b->count];
+                b->values[i] = b->values[b->count];
+                return 1;
+            }
+        }
+    }
+    if ((arg & 3) == HT_INSERT) {
+        b->keys[b->count] = key;
+        b->values[b->count] = 1;
+        b->count++;
+        return 1;
+    }
+    return 0;
+}
+
+static long ht_size(void) {
+    long n = 0;
+    for (int i = 0; i < HT_BUCKETS; i++) {
+        n += table[i].count;
+    }
+    return n;
+}
+
+// ============================================================================
+// Workers
+// ============================================================================
+
+typedef struct {
+    CACHE_ALIGNED mcs_node_t node;
+    int tid;
+    long ops;
+    long net_inserts;    // Successful inserts - successful deletes
+    uint32_t seed;
+} worker_arg_t;
+
+typedef long (*op_fn_t)(void *state, long arg);
+
+static op_fn_t current_op;
+static atomic_int start_flag = 0;
+static atomic_int stop_flag = 0;
+
+static ttas_spinlock_t ttas = TTAS_SPINLOCK_INITIALIZER;
+static backoff_spinlock_t backoff = BACKOFF_SPINLOCK_INITIALIZER;
+static mcs_lock_t mcs = MCS_LOCK_INITIALIZER;
+static pthread_spinlock_t pspin;
+static deleg_server_t server;
+
+/**
+ * Next operation's arg: counter → 1, hash table → 80/10/10 lookup/insert/delete
+ */
+static inline long next_arg(worker_arg_t *a) {
+    if (current_op == counter_op) return 1;
+    uint32_t r = xorshift32(&a->seed);
+    int key = (int)((r >> 8) % HT_KEYS);
+    int pct = (int)(r % 100);
+    int op = pct < 80 ? HT_LOOKUP : pct < 90 ? HT_INSERT : HT_DELETE;
+    return ((long)key << 2) | op;
+}
+
+static inline void account(worker_arg_t *a, long arg, long result) {
+    if (current_op == ht_op && result) {
+        if ((arg & 3) == HT_INSERT) a->net_inserts++;
+        if ((arg & 3) == HT_DELETE) a->net_inserts--;
+    }
+    a->ops++;
+}
+
+#define DEFINE_WORKER(name, lock_expr, unlock_expr)                         \
+    void *name##_worker(void *arg) {                                        \
+        worker_arg_t *a = arg;                                              \
+        while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {  \
+            CPU_PAUSE();                                                    \
+        }                                                                   \
+        while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {   \
+            long op_arg = next_arg(a);                                      \
+            lock_expr;                                                      \
+            long result = current_op(NULL, op_arg);                         \
+            unlock_expr;                                                    \
+            account(a, op_arg, result);                                     \
+            think_ns(THINK_NS);                                             \
+        }                                                                   \
+        return NULL;                                                        \
+    }
+
+DEFINE_WORKER(ttas, ttas_lock(&ttas), ttas_unlock(&ttas))
+DEFINE_WORKER(backoff, backoff_lock(&backoff), backoff_unlock(&backoff))
+DEFINE_WORKER(mcs, mcs_lock(&mcs, &a->node), mcs_unlock(&mcs, &a->node))
+DEFINE_WORKER(pspin, pthread_spin_lock(&pspin), pthread_spin_unlock(&pspin))
+
+void *deleg_worker(void *arg) {
+    worker_arg_t *a = arg;
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        long op_arg = next_arg(a);
+        long result = deleg_call(&server, a->tid, current_op, op_arg);
+        account(a, op_arg, result);
+        think_ns(THINK_NS);
+    }
+    return NULL;
+}
+
+/**
+ * Run one cell for CELL_MS; returns throughput in Mops/s
+ */
+static double run_cell(void *(*worker)(void *), int nthreads) {
+    pthread_t threads[MAX_THREADS];
+    worker_arg_t *args = cache_aligned_alloc(sizeof(worker_arg_t) * nthreads);
+
+    shared_counter = 0;
+    memset(table, 0, sizeof(table));
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    if (worker == deleg_worker) {
+        deleg_start(&server, NULL);
+    }
+    for (int i = 0; i < nthreads; i++) {
+        args[i] = (worker_arg_t){ .tid = i, .seed = 0x9e3779b9u * (i + 1) };
+        pthread_create(&threads[i], NULL, worker, &args[i]);
+    }
+
+    uint64_t start = get_nanos();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    usleep(CELL_MS * 1000);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+
+    long total = 0, net = 0;
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+        total += args[i].ops;
+        net += args[i].net_inserts;
+    }
+    uint64_t elapsed = get_nanos() - start;
+    if (worker == deleg_worker) {
+        deleg_stop(&server);
+    }
+    free(args);
+
+    if (current_op == counter_op && shared_counter != total) {
+        printf("   ✗ INCORRECT counter: %ld (expected %ld)\n", shared_counter, total);
+    }
+    if (current_op == ht_op && ht_size() != net) {
+        printf("   ✗ INCORRECT table size: %ld (expected %ld)\n", ht_size(), net);
+    }
+    return total * 1e3 / elapsed;
+}
+
+static void run_table(const char *title, op_fn_t op) {
+    current_op = op;
+    printf("%s (Mops/s)\n", title);
+    printf("   threads       TTAS    Backoff        MCS  pthr_spin  delegation  reqs/sweep\n");
+    for (int t = 0; t < NUM_T; t++) {
+        int n = thread_counts[t];
+        printf("   %7d", n);
+        printf(" %10.2f", run_cell(ttas_worker, n));
+        printf(" %10.2f", run_cell(backoff_worker, n));
+        printf(" %10.2f", run_cell(mcs_worker, n));
+        printf(" %10.2f", run_cell(pspin_worker, n));
+        printf(" %11.2f", run_cell(deleg_worker, n));
+        printf(" %11.2f\n", deleg_batch_size(&server));
+        fflush(stdout);
+    }
+    printf("\n");
+}
+
+int main() {
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 14: Delegation - Ship the Code, Not the Data\n");
+    printf("  CPUs: %ld, think time: %dns, %dms per cell\n",
+           sysconf(_SC_NPROCESSORS_ONLN), THINK_NS, CELL_MS);
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    pthread_spin_init(&pspin, PTHREAD_PROCESS_PRIVATE);
+
+    run_table("Shared counter", counter_op);
+    run_table("Hash table: 64 buckets, 80% lookup / 10% insert / 10% delete", ht_op);
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • Locks: the data follows the lock from core to core\n");
+    printf("  • Delegation: data stays in the server's L1; each call costs\n");
+    printf("    two line transfers (request, response) regardless of how\n");
+    printf("    many lines the critical section touches\n");
+    printf("  • reqs/sweep > 1: the server batches - one response line\n");
+    printf("    carries %d clients' results\n", DELEG_GROUP);
+    printf("  • Cost: one core dedicated to the server, and a blocking\n");
+    printf("    round-trip per call even when uncontended (1 thread row)\n");
+    printf("  • Fewer cores than clients + server: the server waits for a\n");
+    printf("    timeslice and every client waits on it\n");
+    printf("\n");
+    printf("  ANALYSIS:\n");
+    printf("  make perf-14    - Cache misses: locks vs delegation\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    pthread_spin_destroy(&pspin);
+    return 0;
+}
@@ -0,0 +1,204 @@
+/**
+ * Exercise 15: Trylock, Timeouts and Abortable Queue Locks
+ *
+ * A request handler with a 50us budget would rather fail fast than block
+ * for 5ms behind a slow lock holder. None of exercise 05's locks can give
+ * up. include/spinlock.h now adds, for TAS/TTAS/backoff:
+ *
+ *   *_trylock()          one attempt, never waits
+ *   *_lock_timeout(ns)   spin until the deadline, then return false
+ *
+ * and an abortable CLH queue lock (toq_lock_timeout) whose waiters can
+ * leave the queue on timeout without breaking it for the threads behind.
+ *
+ * Every thread issues "requests" with a deadline: acquire within the
+ * budget, hold for HOLD_NS, or count a miss. For each budget and lock we
+ * report the success rate and the acquire latency of hits and misses
+ * (misses should fail close to the deadline - not long after it).
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <unistd.h>
+#include "benchmark.h"
+#include "spinlock.h"
+
+#define NUM_THREADS 4
+#define CELL_MS 40       // Measurement time per (lock, budget) cell
+#define HOLD_NS 2000     // Critical section length
+#define THINK_NS 1000    // Work between requests
+
+// Deadline budgets; 0 = trylock
+static const uint64_t budgets_ns[] = { 0, 1000, 10000, 100000, 1000000 };
+#define NUM_BUDGETS (int)(sizeof(budgets_ns) / sizeof(budgets_ns[0]))
+
+typedef enum { LOCK_TAS, LOCK_TTAS, LOCK_BACKOFF, LOCK_TOQ, NUM_LOCKS } lock_kind_t;
+static const char *lock_names[] = { "TAS", "TTAS", "Backoff", "CLH-abortable" };
+
+typedef struct {
+    CACHE_ALIGNED toq_thread_t toq;
+    lock_kind_t kind;
+    uint64_t budget;
+    long hits;
+    long misses;
+    hist_t hit_ns;       // Acquire latency of successful requests
+    hist_t miss_ns;      // Time until a failed request gave up
+} worker_arg_t;
+
+static long shared_counter = 0;
+static atomic_int start_flag = 0;
+static atomic_int stop_flag = 0;
+
+static tas_spinlock_t tas = TAS_SPINLOCK_INITIALIZER;
+static ttas_spinlock_t ttas = TTAS_SPINLOCK_INITIALIZER;
+static backoff_spinlock_t backoff = BACKOFF_SPINLOCK_INITIALIZER;
+static toq_lock_t toq = TOQ_LOCK_INITIALIZER;
+
+static inline void busy_ns(uint64_t ns) {
+    uint64_t end = get_nanos() + ns;
+    while (get_nanos() < end) {
+        CPU_PAUSE();
+    }
+}
+
+static inline bool acquire(worker_arg_t *a) {
+    switch (a->kind) {
+    case LOCK_TAS:
+        return a->budget ? tas_lock_timeout(&tas, a->budget) : tas_trylock(&tas);
+    case LOCK_TTAS:
+        return a->budget ? ttas_lock_timeout(&ttas, a->budget) : ttas_trylock(&ttas);
+    case LOCK_BACKOFF:
+        return a->budget ? backoff_lock_timeout(&backoff, a->budget)
+                         : backoff_trylock(&backoff);
+    default:
+        return a->budget ? toq_lock_timeout(&toq, &a->toq, a->budget)
+                         : toq_trylock(&toq, &a->toq);
+    }
+}
+
+static inline void release(worker_arg_t *a) {
+    switch (a->kind) {
+    case LOCK_TAS:     tas_unlock(&tas); break;
+    case LOCK_TTAS:    ttas_unlock(&ttas); break;
+    case LOCK_BACKOFF: backoff_unlock(&backoff); break;
+    default:           toq_unlock(&toq, &a->toq); break;
+    }
+}
+
+void *worker(void *arg) {
+    worker_arg_t *a = arg;
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        uint64_t t0 = get_nanos();
+        if (acquire(a)) {
+            uint64_t waited = get_nanos() - t0;
+            shared_counter++;
+            busy_ns(HOLD_NS);
+            release(a);
+            a->hits++;
+            hist_add(&a->hit_ns, waited);
+        } else {
+            a->misses++;
+            hist_add(&a->miss_ns, get_nanos() - t0);
+        }
+        busy_ns(THINK_NS);
+    }
+    return NULL;
+}
+
+static void run_cell(lock_kind_t kind, uint64_t budget) {
+    pthread_t threads[NUM_THREADS];
+    worker_arg_t *args = cache_aligned_alloc(sizeof(worker_arg_t) * NUM_THREADS);
+    hist_t *hits = calloc(2, sizeof(hist_t)), *misses = hits + 1;
+    long nhits = 0, nmisses = 0;
+    unsigned long nodes = 0;
+
+    memset(args, 0, sizeof(worker_arg_t) * NUM_THREADS);
+    shared_counter = 0;
+    atomic_store(&toq.tail, NULL);  // Previous cell's nodes are freed
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int i = 0; i < NUM_THREADS; i++) {
+        args[i].kind = kind;
+        args[i].budget = budget;
+        pthread_create(&threads[i], NULL, worker, &args[i]);
+    }
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    usleep(CELL_MS * 1000);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        nhits += args[i].hits;
+        nmisses += args[i].misses;
+        hist_merge(hits, &args[i].hit_ns);
+        hist_merge(misses, &args[i].miss_ns);
+        nodes += args[i].toq.allocated;
+        toq_thread_destroy(&args[i].toq);  // All threads joined: safe
+    }
+
+    long total = nhits + nmisses;
+    printf("   %-14s %6.1f%% %9lu %9lu %9lu  %9lu %9lu",
+           lock_names[kind], total ? 100.0 * nhits / total : 0.0,
+           (unsigned long)hist_percentile(hits, 50),
+           (unsigned long)hist_percentile(hits, 99),
+           (unsigned long)hits->max,
+           (unsigned long)hist_percentile(misses, 50),
+           (unsigned long)hist_percentile(misses, 99));
+    if (kind == LOCK_TOQ) {
+        printf("   %lu nodes", nodes);
+    }
+    printf("\n");
+    if (shared_counter != nhits) {
+        printf("   ✗ INCORRECT counter: %ld (expected %ld)\n", shared_counter, nhits);
+    }
+    free(hits);
+    free(args);
+}
+
+int main() {
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 15: Trylock, Timeouts and Abortable Queue Locks\n");
+    printf("  Threads: %d, CPUs: %ld, hold: %dns, think: %dns\n",
+           NUM_THREADS, sysconf(_SC_NPROCESSORS_ONLN), HOLD_NS, THINK_NS);
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    for (int b = 0; b < NUM_BUDGETS; b++) {
+        if (budgets_ns[b] == 0) {
+            printf("Budget: trylock (no waiting)\n");
+        } else {
+            printf("Budget: %lu ns\n", (unsigned long)budgets_ns[b]);
+        }
+        printf("   %-14s %7s %9s %9s %9s  %9s %9s   (ns)\n", "lock", "success",
+               "hit p50", "hit p99", "hit max", "miss p50", "miss p99");
+        for (int k = 0; k < NUM_LOCKS; k++) {
+            run_cell((lock_kind_t)k, budgets_ns[b]);
+        }
+        printf("\n");
+    }
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • miss p50 ≈ budget: waiters give up on time - the contract\n");
+    printf("  • hit max / miss p99 ≫ budget: the thread was descheduled\n");
+    printf("    mid-attempt; a spin timeout can't beat the scheduler\n");
+    printf("  • TAS/TTAS timeouts are unfair: the same threads keep losing.\n");
+    printf("    The CLH lock serves in arrival order, so waiting longer\n");
+    printf("    actually buys you a better position in line\n");
+    printf("  • Abandoned CLH nodes stay in the queue until the successor\n");
+    printf("    skips them; 'nodes' = allocations needed to never block\n");
+    printf("    on node reuse\n");
+    printf("\n");
+    printf("  ANALYSIS:\n");
+    printf("  make tsan-15    - Abort paths are where queue locks break\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    return 0;
+}
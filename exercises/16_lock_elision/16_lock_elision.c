@@ -0,0 +1,219 @@
+/**
+ * Exercise 16: Lock Elision - Hardware Transactions with a Lock Fallback
+ *
+ * A read-mostly table guarded by one TTAS lock: 95% of critical sections
+ * only read, yet every one of them serializes on the lock line.
+ *
+ * include/elision.h runs the critical section as an Intel RTM transaction
+ * (_xbegin/_xend) without writing the lock at all. Readers that don't
+ * touch a line someone else is writing commit in parallel; real conflicts
+ * abort, retry up to ELISION_MAX_RETRIES times and then take the TTAS lock.
+ *
+ * RTM is detected at runtime (CPUID). Without it - most CPUs today, and
+ * every non-x86 machine - the elided lock is just the TTAS lock and the
+ * columns below should match. The abort table tells you WHY transactions
+ * failed (conflict, capacity, lock busy, other).
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <unistd.h>
+#include "benchmark.h"
+#include "spinlock.h"
+#include "elision.h"
+
+#define CELL_MS 50       // Measurement time per (lock, threads) cell
+#define MAX_THREADS 16
+#define TABLE_LINES 256  // 16KB shared table: fits L1, well within RTM limits
+#define READ_LINES 8     // Lines a read-only critical section sums
+#define WRITE_PERCENT 5
+
+static const int thread_counts[] = { 1, 2, 4, 8 };
+#define NUM_T (int)(sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+typedef struct {
+    CACHE_ALIGNED long value;
+} table_line_t;
+
+static table_line_t table[TABLE_LINES];
+
+typedef enum { MODE_TTAS, MODE_ELIDED, MODE_RWLOCK } lock_mode_t;
+
+typedef struct {
+    CACHE_ALIGNED elision_stats_t stats;
+    lock_mode_t mode;
+    uint32_t seed;
+    long ops;
+    long writes;
+    long checksum;       // Keeps the reads from being optimized away
+} worker_arg_t;
+
+static atomic_int start_flag = 0;
+static atomic_int stop_flag = 0;
+
+static ttas_spinlock_t ttas = TTAS_SPINLOCK_INITIALIZER;
+static elided_lock_t elided = ELIDED_LOCK_INITIALIZER;
+static pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+// Critical sections (identical under every lock)
+static inline long read_section(uint32_t r) {
+    long sum = 0;
+    for (int i = 0; i < READ_LINES; i++) {
+        sum += table[(r + i * 31) % TABLE_LINES].value;
+    }
+    return sum;
+}
+
+static inline void write_section(uint32_t r) {
+    table[r % TABLE_LINES].value++;
+}
+
+void *worker(void *arg) {
+    worker_arg_t *a = arg;
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        uint32_t r = xorshift32(&a->seed);
+        bool write = (r >> 24) % 100 < WRITE_PERCENT;
+
+        switch (a->mode) {
+        case MODE_TTAS:
+            ttas_lock(&ttas);
+            if (write) write_section(r); else a->checksum += read_section(r);
+            ttas_unlock(&ttas);
+            break;
+        case MODE_ELIDED:
+            elided_lock(&elided, &a->stats);
+            if (write) write_section(r); else a->checksum += read_section(r);
+            elided_unlock(&elided, &a->stats);
+            break;
+        case MODE_RWLOCK:
+            if (write) {
+                pthread_rwlock_wrlock(&rwlock);
+                write_section(r);
+            } else {
+                pthread_rwlock_rdlock(&rwlock);
+                a->checksum += read_section(r);
+            }
+            pthread_rwlock_unlock(&rwlock);
+            break;
+        }
+        a->writes += write;
+        a->ops++;
+    }
+    return NULL;
+}
+
+static long table_sum(void) {
+    long sum = 0;
+    for (int i = 0; i < TABLE_LINES; i++) {
+        sum += table[i].value;
+    }
+    return sum;
+}
+
+/**
+ * Run one cell for CELL_MS; returns throughput in Mops/s, merges stats
+ */
+static double run_cell(lock_mode_t mode, int nthreads, elision_stats_t *stats) {
+    pthread_t threads[MAX_THREADS];
+    worker_arg_t *args = cache_aligned_alloc(sizeof(worker_arg_t) * nthreads);
+
+    memset(table, 0, sizeof(table));
+    memset(args, 0, sizeof(worker_arg_t) * nthreads);
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int i = 0; i < nthreads; i++) {
+        args[i].mode = mode;
+        args[i].seed = 0x9e3779b9u * (i + 1);
+        pthread_create(&threads[i], NULL, worker, &args[i]);
+    }
+
+    uint64_t start = get_nanos();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    usleep(CELL_MS * 1000);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+
+    long total = 0, writes = 0;
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+        total += args[i].ops;
+        writes += args[i].writes;
+        elision_stats_merge(stats, &args[i].stats);
+    }
+    uint64_t elapsed = get_nanos() - start;
+    free(args);
+
+    if (table_sum() != writes) {
+        printf("   ✗ INCORRECT table: %ld increments (expected %ld)\n",
+               table_sum(), writes);
+    }
+    return total * 1e3 / elapsed;
+}
+
+int main() {
+    bool rtm = elision_rtm_supported();
+    elision_stats_t stats[NUM_T];
+    memset(stats, 0, sizeof(stats));
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 16: Lock Elision (RTM) with TTAS Fallback\n");
+    printf("  CPUs: %ld, RTM: %s, retries before fallback: %d\n",
+           sysconf(_SC_NPROCESSORS_ONLN),
+           rtm ? "available" : "NOT available (elided = plain TTAS)",
+           ELISION_MAX_RETRIES);
+    printf("  CS: %d%% write 1 line / %d%% read %d lines of %d\n",
+           WRITE_PERCENT, 100 - WRITE_PERCENT, READ_LINES, TABLE_LINES);
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    printf("Throughput (Mops/s)\n");
+    printf("   threads       TTAS     elided   rwlock   elided-commit%%\n");
+    for (int t = 0; t < NUM_T; t++) {
+        int n = thread_counts[t];
+        elision_stats_t unused;
+        memset(&unused, 0, sizeof(unused));
+        double plain = run_cell(MODE_TTAS, n, &unused);
+        double elide = run_cell(MODE_ELIDED, n, &stats[t]);
+        double rw = run_cell(MODE_RWLOCK, n, &unused);
+        unsigned long sections = stats[t].commits + stats[t].fallbacks;
+        printf("   %7d %10.2f %10.2f %8.2f %15.1f%%\n", n, plain, elide, rw,
+               sections ? 100.0 * stats[t].commits / sections : 0.0);
+        fflush(stdout);
+    }
+
+    printf("\nAbort reasons (elided lock, all attempts)\n");
+    printf("   threads");
+    for (int k = 0; k < ELISION_ABORT_KINDS; k++) {
+        printf(" %10s", elision_abort_name((elision_abort_t)k));
+    }
+    printf(" %10s\n", "fallbacks");
+    for (int t = 0; t < NUM_T; t++) {
+        printf("   %7d", thread_counts[t]);
+        for (int k = 0; k < ELISION_ABORT_KINDS; k++) {
+            printf(" %10lu", stats[t].aborts[k]);
+        }
+        printf(" %10lu\n", stats[t].fallbacks);
+    }
+
+    printf("\n═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • Elided readers never write the lock line: no ping-pong,\n");
+    printf("    they scale like an rwlock without the reader counter\n");
+    printf("  • conflict aborts: a writer hit a line in your read set\n");
+    printf("  • lock busy: someone fell back to the real lock - everyone\n");
+    printf("    else aborts too (the 'lemming effect'); retries bound it\n");
+    printf("  • capacity aborts: CS footprint > L1 / store buffer, elision\n");
+    printf("    can never work for that CS - don't retry (we don't)\n");
+    printf("  • No RTM: zero commits, 100%% fallbacks, same speed as TTAS\n");
+    printf("\n");
+    printf("  ANALYSIS:\n");
+    printf("  make asm-16     - Find xbegin/xend/xabort in the assembly\n");
+    printf("  perf stat -e tx-start,tx-commit,tx-abort ./exercises/16_lock_elision/16_lock_elision\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    return 0;
+}
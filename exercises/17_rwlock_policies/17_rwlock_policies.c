@@ -0,0 +1,238 @@
+/**
+ * Exercise 17: Reader-Writer Lock Policies
+ *
+ * Exercise 02 uses pthread_rwlock_t with the default policy - on glibc
+ * that prefers readers, and under read-heavy traffic writers starve.
+ *
+ * include/rwlock.h implements three policies with atomics + futex parking:
+ * - reader-preferring  (rp_*): best read throughput, unbounded writer wait
+ * - writer-preferring  (wp_*): writers jump the queue, readers may starve
+ * - phase-fair         (pf_*): reader/writer phases alternate, both bounded
+ *
+ * Every thread mixes reads and writes at a given read ratio. We report read
+ * throughput and the writer's wait-time percentiles for each policy, plus
+ * glibc's default and PREFER_WRITER_NONRECURSIVE_NP rwlocks.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <unistd.h>
+#include "benchmark.h"
+#include "rwlock.h"
+
+#define NUM_THREADS 4
+#define CELL_MS 60       // Measurement time per (policy, read ratio) cell
+#define DATA_LINES 8     // Shared record: readers sum it, writers bump it
+#define THINK_NS 200     // Work between operations
+
+// Read ratios to sweep (percent of operations that are reads);
+// build with EXTRA_CFLAGS="-DREAD_PERCENT=95" to run a single ratio
+#ifdef READ_PERCENT
+static const int read_percents[] = { READ_PERCENT };
+#else
+static const int read_percents[] = { 50, 90, 99 };
+#endif
+#define NUM_RATIOS (int)(sizeof(read_percents) / sizeof(read_percents[0]))
+
+typedef enum {
+    POLICY_RP, POLICY_WP, POLICY_PF, POLICY_GLIBC, POLICY_GLIBC_WP, NUM_POLICIES
+} policy_t;
+
+static const char *policy_names[] = {
+    "reader-pref", "writer-pref", "phase-fair", "glibc default", "glibc writer-np"
+};
+
+typedef struct {
+    CACHE_ALIGNED long value;
+} data_line_t;
+
+static data_line_t shared_data[DATA_LINES];
+
+typedef struct {
+    CACHE_ALIGNED policy_t policy;
+    int read_percent;
+    uint32_t seed;
+    long reads;
+    long writes;
+    long checksum;
+    hist_t write_wait;   // ns from write_lock() call to acquisition
+} worker_arg_t;
+
+static atomic_int start_flag = 0;
+static atomic_int stop_flag = 0;
+
+static rp_rwlock_t rp;
+static wp_rwlock_t wp;
+static pf_rwlock_t pf;
+static pthread_rwlock_t glibc_rw;
+
+static inline void busy_ns(uint64_t ns) {
+    uint64_t end = get_nanos() + ns;
+    while (get_nanos() < end) {
+        CPU_PAUSE();
+    }
+}
+
+static inline void read_lock(policy_t p) {
+    switch (p) {
+    case POLICY_RP: rp_read_lock(&rp); break;
+    case POLICY_WP: wp_read_lock(&wp); break;
+    case POLICY_PF: pf_read_lock(&pf); break;
+    default:        pthread_rwlock_rdlock(&glibc_rw); break;
+    }
+}
+
+static inline void read_unlock(policy_t p) {
+    switch (p) {
+    case POLICY_RP: rp_read_unlock(&rp); break;
+    case POLICY_WP: wp_read_unlock(&wp); break;
+    case POLICY_PF: pf_read_unlock(&pf); break;
+    default:        pthread_rwlock_unlock(&glibc_rw); break;
+    }
+}
+
+static inline void write_lock(policy_t p) {
+    switch (p) {
+    case POLICY_RP: rp_write_lock(&rp); break;
+    case POLICY_WP: wp_write_lock(&wp); break;
+    case POLICY_PF: pf_write_lock(&pf); break;
+    default:        pthread_rwlock_wrlock(&glibc_rw); break;
+    }
+}
+
+static inline void write_unlock(policy_t p) {
+    switch (p) {
+    case POLICY_RP: rp_write_unlock(&rp); break;
+    case POLICY_WP: wp_write_unlock(&wp); break;
+    case POLICY_PF: pf_write_unlock(&pf); break;
+    default:        pthread_rwlock_unlock(&glibc_rw); break;
+    }
+}
+
+void *worker(void *arg) {
+    worker_arg_t *a = arg;
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        if ((int)(xorshift32(&a->seed) % 100) < a->read_percent) {
+            read_lock(a->policy);
+            for (int i = 0; i < DATA_LINES; i++) {
+                a->checksum += shared_data[i].value;
+            }
+            read_unlock(a->policy);
+            a->reads++;
+        } else {
+            uint64_t t0 = get_nanos();
+            write_lock(a->policy);
+            hist_add(&a->write_wait, get_nanos() - t0);
+            for (int i = 0; i < DATA_LINES; i++) {
+                shared_data[i].value++;
+            }
+            write_unlock(a->policy);
+            a->writes++;
+        }
+        busy_ns(THINK_NS);
+    }
+    return NULL;
+}
+
+static void init_locks(policy_t p) {
+    rp = (rp_rwlock_t)RP_RWLOCK_INITIALIZER;
+    wp = (wp_rwlock_t)WP_RWLOCK_INITIALIZER;
+    pf = (pf_rwlock_t)PF_RWLOCK_INITIALIZER;
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    if (p == POLICY_GLIBC_WP) {
+        pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    }
+    pthread_rwlock_init(&glibc_rw, &attr);
+    pthread_rwlockattr_destroy(&attr);
+}
+
+static void run_cell(policy_t policy, int read_percent) {
+    pthread_t threads[NUM_THREADS];
+    worker_arg_t *args = cache_aligned_alloc(sizeof(worker_arg_t) * NUM_THREADS);
+    hist_t *wait = calloc(1, sizeof(hist_t));
+    long reads = 0, writes = 0;
+
+    memset(args, 0, sizeof(worker_arg_t) * NUM_THREADS);
+    memset(shared_data, 0, sizeof(shared_data));
+    init_locks(policy);
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int i = 0; i < NUM_THREADS; i++) {
+        args[i].policy = policy;
+        args[i].read_percent = read_percent;
+        args[i].seed = 0x9e3779b9u * (i + 1);
+        pthread_create(&threads[i], NULL, worker, &args[i]);
+    }
+
+    uint64_t start = get_nanos();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    usleep(CELL_MS * 1000);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        reads += args[i].reads;
+        writes += args[i].writes;
+        hist_merge(wait, &args[i].write_wait);
+    }
+    double secs = (get_nanos() - start) / 1e9;
+    pthread_rwlock_destroy(&glibc_rw);
+
+    printf("   %-16s %9.2f %9.1f %10.1f %10.1f %10.1f\n",
+           policy_names[policy], reads / secs / 1e6, writes / secs / 1e3,
+           hist_percentile(wait, 50) / 1e3, hist_percentile(wait, 99) / 1e3,
+           wait->max / 1e3);
+    for (int i = 0; i < DATA_LINES; i++) {
+        if (shared_data[i].value != writes) {
+            printf("   ✗ INCORRECT: line %d = %ld (expected %ld)\n",
+                   i, shared_data[i].value, writes);
+            break;
+        }
+    }
+    free(wait);
+    free(args);
+}
+
+int main() {
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 17: Reader-Writer Lock Policies\n");
+    printf("  Threads: %d, CPUs: %ld, %dms per cell\n",
+           NUM_THREADS, sysconf(_SC_NPROCESSORS_ONLN), CELL_MS);
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    for (int r = 0; r < NUM_RATIOS; r++) {
+        printf("Read ratio: %d%%\n", read_percents[r]);
+        printf("   %-16s %9s %9s %10s %10s %10s\n", "policy", "reads M/s",
+               "writes K/s", "w-wait p50", "w-wait p99", "w-wait max");
+        for (int p = 0; p < NUM_POLICIES; p++) {
+            run_cell((policy_t)p, read_percents[r]);
+            fflush(stdout);
+        }
+        printf("   (writer wait in us)\n\n");
+    }
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • reader-pref: highest read rate, writer p99/max explode as\n");
+    printf("    the read ratio rises - readers overlap and never let go\n");
+    printf("  • writer-pref: a waiting writer closes the door on readers;\n");
+    printf("    low writer latency, read throughput pays for it\n");
+    printf("  • phase-fair: each writer waits for at most ONE reader phase\n");
+    printf("    and each reader for at most one writer - bounded both ways\n");
+    printf("  • glibc default behaves like reader-pref; the _NP writer kind\n");
+    printf("    is glibc's answer to writer starvation\n");
+    printf("\n");
+    printf("  ANALYSIS:\n");
+    printf("  make tsan-17    - Check the hand-rolled locks for races\n");
+    printf("  make -B run-17 EXTRA_CFLAGS=\"-DREAD_PERCENT=95\"\n");
+    printf("  strace -c -f -e futex ./exercises/17_rwlock_policies/17_rwlock_policies\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    return 0;
+}
@@ -0,0 +1,275 @@
+/**
+ * Exercise 20: Userspace RCU (QSBR) Instead of a Reader-Writer Lock
+ *
+ * Exercise 02's shared_data pattern, grown up: a configuration record read
+ * constantly and replaced now and then. With pthread_rwlock_t every read
+ * writes the lock's reader count.
+ *
+ * With RCU (include/rcu.h) the updater never modifies the live record: it
+ * builds a new copy, publishes it with rcu_assign_pointer() and frees the
+ * old one only after a grace period. Readers just rcu_dereference() - no
+ * atomics, no stores - and report a quiescent state between reads.
+ *
+ * Updaters either wait for the grace period (synchronize_rcu) or hand the
+ * old copy to the reclaimer thread (call_rcu). We measure read throughput
+ * and the updater's latency for each. Freed records are poisoned first, so
+ * a reader that sees a freed copy is caught.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <unistd.h>
+#include <time.h>
+#include "benchmark.h"
+#include "rcu.h"
+
+#define CELL_MS 40       // Measurement time per (mode, readers) cell
+#define MAX_READERS 16
+#define CONFIG_WORDS 32  // Record payload: 4 cache lines
+#define UPDATE_INTERVAL_US 200
+#define POISON 0xdeadbeefUL
+
+static const int reader_counts[] = { 1, 2, 4, 8 };
+#define NUM_R (int)(sizeof(reader_counts) / sizeof(reader_counts[0]))
+
+typedef enum { MODE_RWLOCK, MODE_RCU_SYNC, MODE_RCU_CALL, NUM_MODES } update_mode_t;
+static const char *mode_names[] = { "rwlock", "RCU sync", "RCU call_rcu" };
+
+typedef struct {
+    rcu_head_t rcu;      // For call_rcu()
+    unsigned long version;
+    unsigned long words[CONFIG_WORDS];
+} config_t;
+
+static _Atomic(config_t *) current_config;     // RCU-protected
+static config_t rw_config;                      // rwlock-protected, in place
+static pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+typedef struct {
+    CACHE_ALIGNED update_mode_t mode;
+    long ops;
+    long bad;            // Torn or freed records seen
+    unsigned long sink;
+    hist_t latency;      // Updater only: ns per update
+} worker_arg_t;
+
+static atomic_int start_flag = 0;
+static atomic_int stop_flag = 0;
+
+static config_t *config_new(unsigned long version) {
+    config_t *c = malloc(sizeof(config_t));
+    c->version = version;
+    for (int i = 0; i < CONFIG_WORDS; i++) {
+        c->words[i] = version;
+    }
+    return c;
+}
+
+static void config_free(config_t *c) {
+    c->version = POISON;  // A reader still using it will notice
+    for (int i = 0; i < CONFIG_WORDS; i++) {
+        c->words[i] = POISON;
+    }
+    free(c);
+}
+
+static void config_free_rcu(rcu_head_t *head) {
+    config_free((config_t *)head);  // rcu is the first member
+}
+
+static inline bool config_check(const config_t *c, unsigned long *sink) {
+    unsigned long v = c->version;
+    bool ok = v != POISON;
+    for (int i = 0; i < CONFIG_WORDS; i++) {
+        ok &= c->words[i] == v;
+        *sink += c->words[i];
+    }
+    return ok;
+}
+
+void *reader(void *arg) {
+    worker_arg_t *a = arg;
+    if (a->mode != MODE_RWLOCK) {
+        rcu_register_thread();
+    }
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        bool ok;
+        if (a->mode == MODE_RWLOCK) {
+            pthread_rwlock_rdlock(&rwlock);
+            ok = config_check(&rw_config, &a->sink);
+            pthread_rwlock_unlock(&rwlock);
+        } else {
+            rcu_read_lock();
+            ok = config_check(rcu_dereference(current_config), &a->sink);
+            rcu_read_unlock();
+            rcu_quiescent_state();  // Between reads: no references held
+        }
+        a->bad += !ok;
+        a->ops++;
+    }
+    if (a->mode != MODE_RWLOCK) {
+        rcu_unregister_thread();
+    }
+    return NULL;
+}
+
+void *updater(void *arg) {
+    worker_arg_t *a = arg;
+    unsigned long version = 1;
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        uint64_t t0 = get_nanos();
+        version++;
+        if (a->mode == MODE_RWLOCK) {
+            pthread_rwlock_wrlock(&rwlock);
+            rw_config.version = version;
+            for (int i = 0; i < CONFIG_WORDS; i++) {
+                rw_config.words[i] = version;
+            }
+            pthread_rwlock_unlock(&rwlock);
+        } else {
+            config_t *old = atomic_load_explicit(&current_config, memory_order_relaxed);
+            rcu_assign_pointer(current_config, config_new(version));
+            if (a->mode == MODE_RCU_SYNC) {
+                synchronize_rcu();
+                config_free(old);
+            } else {
+                call_rcu(&old->rcu, config_free_rcu);
+            }
+        }
+        hist_add(&a->latency, get_nanos() - t0);
+        a->ops++;
+        sleep_for_us(UPDATE_INTERVAL_US);
+    }
+    return NULL;
+}
+
+typedef struct {
+    double read_mops;
+    long updates;
+    uint64_t p50, p99;
+} cell_result_t;
+
+static cell_result_t run_cell(update_mode_t mode, int nreaders) {
+    pthread_t threads[MAX_READERS + 1];
+    worker_arg_t *args = cache_aligned_alloc(sizeof(worker_arg_t) * (nreaders + 1));
+    worker_arg_t *u = &args[nreaders];
+
+    memset(args, 0, sizeof(worker_arg_t) * (nreaders + 1));
+    rw_config = (config_t){ .version = 1 };
+    for (int i = 0; i < CONFIG_WORDS; i++) {
+        rw_config.words[i] = 1;
+    }
+    atomic_store(&current_config, config_new(1));
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int i = 0; i <= nreaders; i++) {
+        args[i].mode = mode;
+        pthread_create(&threads[i], NULL, i < nreaders ? reader : updater, &args[i]);
+    }
+
+    uint64_t start = get_nanos();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    usleep(CELL_MS * 1000);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+
+    long reads = 0, bad = 0;
+    for (int i = 0; i <= nreaders; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < nreaders; i++) {
+        reads += args[i].ops;
+        bad += args[i].bad;
+    }
+    double secs = (get_nanos() - start) / 1e9;
+    free(atomic_load(&current_config));  // No readers left
+
+    if (bad) {
+        printf("   ✗ INCORRECT: %ld reads saw a torn or freed record (%s)\n",
+               bad, mode_names[mode]);
+    }
+    cell_result_t r = {
+        .read_mops = reads / secs / 1e6,
+        .updates = u->ops,
+        .p50 = hist_percentile(&u->latency, 50),
+        .p99 = hist_percentile(&u->latency, 99),
+    };
+    free(args);
+    return r;
+}
+
+int main() {
+    cell_result_t results[NUM_R][NUM_MODES];
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 20: Userspace RCU (QSBR) vs pthread_rwlock\n");
+    printf("  CPUs: %ld, record: %d words, 1 updater every %d us\n",
+           sysconf(_SC_NPROCESSORS_ONLN), CONFIG_WORDS, UPDATE_INTERVAL_US);
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    rcu_reclaimer_start();
+    for (int n = 0; n < NUM_R; n++) {
+        for (int m = 0; m < NUM_MODES; m++) {
+            results[n][m] = run_cell((update_mode_t)m, reader_counts[n]);
+        }
+    }
+    rcu_reclaimer_stop();
+
+    printf("Read throughput (M reads/s)\n");
+    printf("   readers");
+    for (int m = 0; m < NUM_MODES; m++) {
+        printf(" %14s", mode_names[m]);
+    }
+    printf("\n");
+    for (int n = 0; n < NUM_R; n++) {
+        printf("   %7d", reader_counts[n]);
+        for (int m = 0; m < NUM_MODES; m++) {
+            printf(" %14.2f", results[n][m].read_mops);
+        }
+        printf("\n");
+    }
+
+    printf("\nUpdate latency p50 / p99 (us)\n");
+    printf("   readers");
+    for (int m = 0; m < NUM_MODES; m++) {
+        printf(" %20s", mode_names[m]);
+    }
+    printf("\n");
+    for (int n = 0; n < NUM_R; n++) {
+        printf("   %7d", reader_counts[n]);
+        for (int m = 0; m < NUM_MODES; m++) {
+            printf("      %6.1f / %7.1f", results[n][m].p50 / 1e3, results[n][m].p99 / 1e3);
+        }
+        printf("\n");
+    }
+    printf("\nReclaimer: %lu grace periods for %lu call_rcu() callbacks\n",
+           atomic_load(&rcu_reclaimer.grace_periods),
+           atomic_load(&rcu_reclaimer.callbacks));
+
+    printf("\n═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • RCU reads are plain loads: no lock word, no shared store.\n");
+    printf("    The quiescent state writes only the reader's OWN line\n");
+    printf("  • synchronize_rcu() waits for every reader to pass a\n");
+    printf("    quiescent state - its latency grows with reader count\n");
+    printf("    (on 1 CPU: with how long until each reader is scheduled)\n");
+    printf("  • call_rcu() returns at once; the reclaimer batches many\n");
+    printf("    callbacks into one grace period\n");
+    printf("  • The cost is memory: old copies live until the grace\n");
+    printf("    period ends, and readers must never block while online\n");
+    printf("\n");
+    printf("  ANALYSIS:\n");
+    printf("  make asm-20     - Reader loop: no lock prefix, no fences\n");
+    printf("  make tsan-20    - Grace periods order the free after reads\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    return 0;
+}
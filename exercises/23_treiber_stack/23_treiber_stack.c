@@ -0,0 +1,262 @@
+/**
+ * Exercise 23: Treiber Lock-Free Stack, ABA and Elimination
+ *
+ * API.md shows compare-and-swap one variable at a time. The classic first
+ * CAS-based container is Treiber's stack: push and pop are a single CAS on
+ * `top`. It is also the classic ABA trap - see include/lfstack.h, where top
+ * is a {tag, index} pair in one 64-bit word so a recycled node never fools
+ * a stale CAS.
+ *
+ * Every thread repeatedly pops a node and pushes it back. We compare:
+ *   - a mutex-protected array stack
+ *   - the Treiber stack
+ *   - the Treiber stack with an elimination-backoff array
+ * and then use the stack as the free list of a lock-free object pool,
+ * against malloc()/free().
+ *
+ * After each cell the stack is drained: every node must come back exactly
+ * once - a lost or duplicated node means ABA (or a bug) got through.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <unistd.h>
+#include "benchmark.h"
+#include "lfstack.h"
+
+#define CELL_MS 40       // Measurement time per (stack, threads) cell
+#define MAX_THREADS 16
+#define STACK_NODES 1024
+#define OBJECT_SIZE 64
+
+static const int thread_counts[] = { 1, 2, 4, 8 };
+#define NUM_T (int)(sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+typedef enum { MODE_MUTEX, MODE_TREIBER, MODE_ELIM, MODE_POOL, MODE_MALLOC,
+               NUM_MODES } stack_mode_t;
+static const char *mode_names[] = { "mutex", "Treiber", "Treiber+elim",
+                                    "lf_pool", "malloc" };
+
+// Mutex baseline: array stack of node indices
+typedef struct {
+    pthread_mutex_t lock;
+    uint32_t items[STACK_NODES];
+    uint32_t size;
+} mutex_stack_t;
+
+static mutex_stack_t mstack = { .lock = PTHREAD_MUTEX_INITIALIZER };
+static lf_stack_t lfstack;
+static lf_pool_t pool;
+
+typedef struct {
+    CACHE_ALIGNED stack_mode_t mode;
+    long ops;
+    long empty;          // Pops that found nothing
+    unsigned long eliminated;
+} worker_arg_t;
+
+static atomic_int start_flag = 0;
+static atomic_int stop_flag = 0;
+
+static inline uint32_t mstack_pop(void) {
+    uint32_t v = LFS_EMPTY;
+    pthread_mutex_lock(&mstack.lock);
+    if (mstack.size > 0) {
+        v = mstack.items[--mstack.size];
+    }
+    pthread_mutex_unlock(&mstack.lock);
+    return v;
+}
+
+static inline void mstack_push(uint32_t v) {
+    pthread_mutex_lock(&mstack.lock);
+    mstack.items[mstack.size++] = v;
+    pthread_mutex_unlock(&mstack.lock);
+}
+
+void *worker(void *arg) {
+    worker_arg_t *a = arg;
+    lfs_eliminated = 0;
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        uint32_t v;
+        void *obj;
+        switch (a->mode) {
+        case MODE_MUTEX:
+            if ((v = mstack_pop()) == LFS_EMPTY) { a->empty++; break; }
+            mstack_push(v);
+            break;
+        case MODE_TREIBER:
+        case MODE_ELIM:
+            if ((v = lfs_pop(&lfstack)) == LFS_EMPTY) { a->empty++; break; }
+            lfs_push(&lfstack, v);
+            break;
+        case MODE_POOL:
+            if ((obj = lf_pool_alloc(&pool)) == NULL) { a->empty++; break; }
+            *(volatile long *)obj = a->ops;  // Touch it like a real user
+            lf_pool_free(&pool, obj);
+            break;
+        default:
+            obj = malloc(OBJECT_SIZE);
+            *(volatile long *)obj = a->ops;
+            free(obj);
+            break;
+        }
+        a->ops++;
+    }
+    a->eliminated = lfs_eliminated;
+    return NULL;
+}
+
+/**
+ * Pop everything; true if every node came back exactly once
+ */
+static bool drain_check(stack_mode_t mode) {
+    static unsigned char seen[STACK_NODES];
+    lf_stack_t *s = mode == MODE_POOL ? &pool.free_list : &lfstack;
+    uint32_t v, count = 0;
+    bool ok = true;
+
+    if (mode == MODE_MALLOC) {
+        return true;
+    }
+    memset(seen, 0, sizeof(seen));
+    while ((v = mode == MODE_MUTEX ? mstack_pop() : lfs_pop(s)) != LFS_EMPTY) {
+        ok &= v < STACK_NODES && !seen[v];
+        if (v < STACK_NODES) seen[v] = 1;
+        count++;
+    }
+    return ok && count == STACK_NODES;
+}
+
+static void setup(stack_mode_t mode) {
+    switch (mode) {
+    case MODE_MUTEX:
+        for (uint32_t i = 0; i < STACK_NODES; i++) {
+            mstack.items[i] = i;
+        }
+        mstack.size = STACK_NODES;
+        break;
+    case MODE_TREIBER:
+    case MODE_ELIM:
+        lfs_init(&lfstack, STACK_NODES, mode == MODE_ELIM);
+        for (uint32_t i = 0; i < STACK_NODES; i++) {
+            lfs_push(&lfstack, i);
+        }
+        break;
+    case MODE_POOL:
+        lf_pool_init(&pool, STACK_NODES, OBJECT_SIZE, true);
+        break;
+    default:
+        break;
+    }
+}
+
+static void teardown(stack_mode_t mode) {
+    if (mode == MODE_TREIBER || mode == MODE_ELIM) {
+        lfs_destroy(&lfstack);
+    } else if (mode == MODE_POOL) {
+        lf_pool_destroy(&pool);
+    }
+}
+
+/**
+ * Run one cell; returns Mops/s (one op = pop + push)
+ */
+static double run_cell(stack_mode_t mode, int nthreads, double *elim_pct) {
+    pthread_t threads[MAX_THREADS];
+    worker_arg_t *args = cache_aligned_alloc(sizeof(worker_arg_t) * nthreads);
+
+    memset(args, 0, sizeof(worker_arg_t) * nthreads);
+    setup(mode);
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int i = 0; i < nthreads; i++) {
+        args[i].mode = mode;
+        pthread_create(&threads[i], NULL, worker, &args[i]);
+    }
+
+    uint64_t start = get_nanos();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    usleep(CELL_MS * 1000);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+
+    long ops = 0, empty = 0;
+    unsigned long eliminated = 0;
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+        ops += args[i].ops;
+        empty += args[i].empty;
+        eliminated += args[i].eliminated;
+    }
+    uint64_t elapsed = get_nanos() - start;
+
+    if (empty || !drain_check(mode)) {
+        printf("   ✗ INCORRECT (%s, %d threads): nodes lost or duplicated\n",
+               mode_names[mode], nthreads);
+    }
+    teardown(mode);
+    free(args);
+    // Each eliminated pair counts twice (the push and the pop)
+    *elim_pct = ops ? 100.0 * eliminated / (2.0 * ops) : 0.0;
+    return ops * 1e3 / elapsed;
+}
+
+int main() {
+    double elim[NUM_T];
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 23: Treiber Stack vs Mutex Stack\n");
+    printf("  CPUs: %ld, nodes: %d, elimination slots: %d\n",
+           sysconf(_SC_NPROCESSORS_ONLN), STACK_NODES, LFS_ELIM_SLOTS);
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    printf("Throughput (M pop+push pairs/s)\n");
+    printf("   threads");
+    for (int m = 0; m < NUM_MODES; m++) {
+        printf(" %13s", mode_names[m]);
+    }
+    printf("   eliminated\n");
+    for (int t = 0; t < NUM_T; t++) {
+        int n = thread_counts[t];
+        printf("   %7d", n);
+        for (int m = 0; m < NUM_MODES; m++) {
+            double pct;
+            printf(" %13.2f", run_cell((stack_mode_t)m, n, &pct));
+            if (m == MODE_ELIM) {
+                elim[t] = pct;
+            }
+            fflush(stdout);
+        }
+        printf("   %9.1f%%\n", elim[t]);
+    }
+
+    printf("\n═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • One CAS per operation, no lock holder to be descheduled:\n");
+    printf("    a stalled thread never blocks the others\n");
+    printf("  • Every thread still CASes ONE word - the stack top is a\n");
+    printf("    serialization point just like a lock; it doesn't scale\n");
+    printf("  • Elimination lets a push and a pop cancel in a side slot,\n");
+    printf("    so throughput can grow with contention\n");
+    printf("  • 'eliminated' needs pushes and pops overlapping on different\n");
+    printf("    CPUs - expect 0%% on a single core\n");
+    printf("  • glibc malloc has per-thread caches (tcache): no shared\n");
+    printf("    word at all, so it wins here. The pool's value is fixed\n");
+    printf("    memory and a lock-free path usable where malloc isn't\n");
+    printf("  • The {tag, index} top defeats ABA, and because nodes are\n");
+    printf("    never freed a racing pop can't read freed memory - the\n");
+    printf("    same property that makes it a good pool free list\n");
+    printf("\n");
+    printf("  ANALYSIS:\n");
+    printf("  make tsan-23    - Push/pop races under ThreadSanitizer\n");
+    printf("  make asm-23     - Find the lock cmpxchg in lfs_push/lfs_pop\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    return 0;
+}
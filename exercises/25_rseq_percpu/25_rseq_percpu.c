@@ -0,0 +1,313 @@
+/**
+ * Exercise 25: Restartable Sequences - Per-CPU Counters and Free Lists
+ *
+ * Exercise 01's counters are one atomic_fetch_add on one line. Exercise 03's
+ * padded per-thread counters scale, but memory and read cost grow with the
+ * THREAD count: hundreds of threads on 64 CPUs means hundreds of lines.
+ *
+ * Per-CPU data needs only one line per CPU. The catch: a thread can move
+ * between reading its CPU number and updating that CPU's slot, so updates
+ * stay lock-prefixed - unless the kernel restarts the update whenever the
+ * thread is preempted or migrated in the middle. That is rseq; see
+ * include/rseq_percpu.h.
+ *
+ * Part 1 - counters: one atomic, per-thread padded shards, per-CPU slots
+ *          updated with lock xadd, and per-CPU slots updated with rseq.
+ * Part 2 - free lists: pop + push on a mutex stack, a global Treiber stack
+ *          (include/lfstack.h), and per-CPU lists with rseq push/pop.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <unistd.h>
+#include "benchmark.h"
+#include "rseq_percpu.h"
+#include "sharded_counter.h"
+#include "lfstack.h"
+
+#define CELL_MS 25       // Measurement time per (mode, threads) cell
+#define MAX_THREADS 64
+#define LIST_NODES 4096
+
+static const int thread_counts[] = { 1, 4, 16, 64 };
+#define NUM_T (int)(sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+typedef enum { MODE_ATOMIC, MODE_PER_THREAD, MODE_PER_CPU_ATOMIC, MODE_PER_CPU_RSEQ,
+               NUM_COUNTER_MODES } counter_mode_t;
+static const char *counter_names[] = { "atomic", "per-thread", "per-CPU lock", "per-CPU rseq" };
+
+typedef enum { MODE_MUTEX, MODE_TREIBER, MODE_PC_LIST, NUM_LIST_MODES } list_mode_t;
+static const char *list_names[] = { "mutex", "Treiber", "per-CPU rseq" };
+
+static CACHE_ALIGNED atomic_long single_counter = 0;
+static sharded_counter_t per_thread;
+static pc_counter_t per_cpu;
+
+// Mutex baseline: intrusive LIFO
+static pthread_mutex_t mlist_lock = PTHREAD_MUTEX_INITIALIZER;
+static pc_node_t *mlist_head;
+
+static lf_stack_t lfstack;
+static pc_list_t pc_list;
+static pc_node_t *nodes;
+
+typedef struct {
+    CACHE_ALIGNED int part;
+    int mode;
+    long ops;
+    long empty;          // Pops that found this CPU's list empty
+} worker_arg_t;
+
+static atomic_int start_flag = 0;
+static atomic_int stop_flag = 0;
+
+static inline void count_one(counter_mode_t mode) {
+    switch (mode) {
+    case MODE_ATOMIC:
+        atomic_fetch_add_explicit(&single_counter, 1, memory_order_relaxed);
+        break;
+    case MODE_PER_THREAD:
+        sc_inc(&per_thread);
+        break;
+    case MODE_PER_CPU_ATOMIC:
+        pc_counter_add_atomic(&per_cpu, 1);
+        break;
+    default:
+        pc_counter_add(&per_cpu, 1);
+        break;
+    }
+}
+
+static inline bool pop_push_one(list_mode_t mode) {
+    pc_node_t *n;
+    uint32_t i;
+    switch (mode) {
+    case MODE_MUTEX:
+        pthread_mutex_lock(&mlist_lock);
+        if ((n = mlist_head) != NULL) {
+            mlist_head = n->next;
+        }
+        pthread_mutex_unlock(&mlist_lock);
+        if (n == NULL) return false;
+        pthread_mutex_lock(&mlist_lock);
+        n->next = mlist_head;
+        mlist_head = n;
+        pthread_mutex_unlock(&mlist_lock);
+        return true;
+    case MODE_TREIBER:
+        if ((i = lfs_pop(&lfstack)) == LFS_EMPTY) return false;
+        lfs_push(&lfstack, i);
+        return true;
+    default:
+        if ((n = pc_list_pop(&pc_list)) == NULL) return false;
+        pc_list_push(&pc_list, n);
+        return true;
+    }
+}
+
+void *worker(void *arg) {
+    worker_arg_t *a = arg;
+    rseq_register_current_thread();
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        if (a->part == 1) {
+            count_one((counter_mode_t)a->mode);
+        } else if (!pop_push_one((list_mode_t)a->mode)) {
+            a->empty++;
+        }
+        a->ops++;
+    }
+    rseq_unregister_current_thread();
+    return NULL;
+}
+
+static void list_setup(list_mode_t mode) {
+    memset(nodes, 0, sizeof(pc_node_t) * LIST_NODES);
+    switch (mode) {
+    case MODE_MUTEX:
+        mlist_head = NULL;
+        for (int i = 0; i < LIST_NODES; i++) {
+            nodes[i].next = mlist_head;
+            mlist_head = &nodes[i];
+        }
+        break;
+    case MODE_TREIBER:
+        lfs_init(&lfstack, LIST_NODES, false);
+        for (uint32_t i = 0; i < LIST_NODES; i++) {
+            lfs_push(&lfstack, i);
+        }
+        break;
+    default:
+        // Spread the nodes evenly over the CPUs
+        pc_list_init(&pc_list);
+        for (int i = 0; i < LIST_NODES; i++) {
+            pc_list_push_cpu(&pc_list, &nodes[i], i);
+        }
+        break;
+    }
+}
+
+/**
+ * Take everything back out; true if every node came back exactly once
+ */
+static bool list_drain_check(list_mode_t mode) {
+    static unsigned char seen[LIST_NODES];
+    long count = 0;
+    bool ok = true;
+
+    memset(seen, 0, sizeof(seen));
+    if (mode == MODE_TREIBER) {
+        uint32_t i;
+        while ((i = lfs_pop(&lfstack)) != LFS_EMPTY) {
+            ok &= i < LIST_NODES && !seen[i];
+            if (i < LIST_NODES) seen[i] = 1;
+            count++;
+        }
+        lfs_destroy(&lfstack);
+        return ok && count == LIST_NODES;
+    }
+
+    for (int c = 0; c < (mode == MODE_MUTEX ? 1 : pc_list.ncpus); c++) {
+        pc_node_t *n = mode == MODE_MUTEX ? mlist_head : pc_list.heads[c].head;
+        for (; n != NULL && count <= LIST_NODES; n = n->next) {
+            long i = n - nodes;
+            ok &= i >= 0 && i < LIST_NODES && !seen[i];
+            if (i >= 0 && i < LIST_NODES) seen[i] = 1;
+            count++;
+        }
+    }
+    if (mode == MODE_PC_LIST) {
+        pc_list_destroy(&pc_list);
+    }
+    return ok && count == LIST_NODES;
+}
+
+/**
+ * Run one cell; returns Mops/s
+ */
+static double run_cell(int part, int mode, int nthreads) {
+    pthread_t threads[MAX_THREADS];
+    worker_arg_t *args = cache_aligned_alloc(sizeof(worker_arg_t) * nthreads);
+
+    memset(args, 0, sizeof(worker_arg_t) * nthreads);
+    if (part == 1) {
+        atomic_store(&single_counter, 0);
+        sc_reset(&per_thread);
+        pc_counter_reset(&per_cpu);
+    } else {
+        list_setup((list_mode_t)mode);
+    }
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int i = 0; i < nthreads; i++) {
+        args[i].part = part;
+        args[i].mode = mode;
+        pthread_create(&threads[i], NULL, worker, &args[i]);
+    }
+
+    uint64_t start = get_nanos();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    usleep(CELL_MS * 1000);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+
+    long ops = 0, empty = 0;
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+        ops += args[i].ops;
+        empty += args[i].empty;
+    }
+    uint64_t elapsed = get_nanos() - start;
+
+    if (part == 1) {
+        long got = mode == MODE_ATOMIC ? atomic_load(&single_counter)
+                 : mode == MODE_PER_THREAD ? sc_read(&per_thread)
+                 : pc_counter_read(&per_cpu);
+        if (got != ops) {
+            printf("   ✗ INCORRECT (%s): counter %ld, expected %ld\n",
+                   counter_names[mode], got, ops);
+        }
+    } else {
+        if (!list_drain_check((list_mode_t)mode)) {
+            printf("   ✗ INCORRECT (%s, %d threads): nodes lost or duplicated\n",
+                   list_names[mode], nthreads);
+        }
+        ops -= empty;
+    }
+    free(args);
+    return ops * 1e3 / elapsed;
+}
+
+int main() {
+    int ncpus = pc_num_cpus();
+
+    sc_init(&per_thread, 0);
+    pc_counter_init(&per_cpu);
+    nodes = cache_aligned_alloc(sizeof(pc_node_t) * LIST_NODES);
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 25: rseq Per-CPU Counters and Free Lists\n");
+    printf("  CPUs: %d, rseq: %s\n", ncpus,
+           rseq_available() ? (rseq_own_registered ? "registered by us" : "registered by glibc")
+                            : "unavailable - per-CPU ops fall back to atomics");
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    printf("1. Counter increments (Mops/s)\n");
+    printf("   threads");
+    for (int m = 0; m < NUM_COUNTER_MODES; m++) {
+        printf(" %13s", counter_names[m]);
+    }
+    printf("   shard memory (thread / CPU)\n");
+    for (int t = 0; t < NUM_T; t++) {
+        int n = thread_counts[t];
+        printf("   %7d", n);
+        for (int m = 0; m < NUM_COUNTER_MODES; m++) {
+            printf(" %13.2f", run_cell(1, m, n));
+            fflush(stdout);
+        }
+        printf("   %6d B / %d B\n", n * CACHE_LINE_SIZE, ncpus * CACHE_LINE_SIZE);
+    }
+
+    printf("\n2. Free list pop + push (M pairs/s)\n");
+    printf("   threads");
+    for (int m = 0; m < NUM_LIST_MODES; m++) {
+        printf(" %13s", list_names[m]);
+    }
+    printf("\n");
+    for (int t = 0; t < NUM_T; t++) {
+        int n = thread_counts[t];
+        printf("   %7d", n);
+        for (int m = 0; m < NUM_LIST_MODES; m++) {
+            printf(" %13.2f", run_cell(2, m, n));
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    pc_counter_destroy(&per_cpu);
+    free(nodes);
+
+    printf("\n═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • Per-thread shards cost a line per thread; per-CPU slots\n");
+    printf("    cost a line per CPU however many threads you run\n");
+    printf("  • Per-CPU with lock xadd pays the atomic even though the\n");
+    printf("    line is usually local; rseq's plain addq does not\n");
+    printf("  • A preempted or migrated rseq section is restarted by the\n");
+    printf("    kernel at its abort handler - nothing half-done survives\n");
+    printf("  • The rseq list reads head AND head->next inside one\n");
+    printf("    section, so no ABA tag is needed, unlike lfstack.h\n");
+    printf("  • On 1 CPU every per-CPU structure is one slot: rseq is\n");
+    printf("    then just an uncontended, lock-free single list\n");
+    printf("\n");
+    printf("  ANALYSIS:\n");
+    printf("  make asm-25     - No lock prefix inside the __rseq_cs sections\n");
+    printf("  make -B run-25 EXTRA_CFLAGS=\"-DNO_RSEQ\" - Fallback path\n");
+    printf("  GLIBC_TUNABLES=glibc.pthread.rseq=0 ./exercises/25_rseq_percpu/25_rseq_percpu\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    return 0;
+}
@@ -0,0 +1,2 @@
+// Same as main file - full implementations provided
+#include "26_atomic_cost_matrix.c"
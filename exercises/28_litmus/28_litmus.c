@@ -0,0 +1,385 @@
+/**
+ * Exercise 28: Memory-Ordering Litmus Tests
+ *
+ * Exercise 04 runs each producer/consumer pair a handful of times. Weak
+ * behaviours need two threads to hit a window of a few nanoseconds at the
+ * same moment - you won't see one in three tries, even on x86 where store
+ * buffering is real.
+ *
+ * This engine runs the classic litmus tests many times:
+ *   - threads pinned to different CPUs of our affinity mask (when there
+ *     are enough); a failed pin is reported, not ignored
+ *   - every iteration starts with a per-iteration barrier, then a random
+ *     0..MAX_DELAY pause per thread so the windows slide past each other
+ *   - every iteration uses fresh, cache-line-separated x and y
+ * and prints the histogram of outcomes for each memory-order/fence variant.
+ * The outcome sequential consistency forbids is marked with '*'.
+ *
+ *   SB    store buffering     T0: x=1; r0=y       T1: y=1; r1=x
+ *   MP    message passing     T0: x=1; y=1        T1: r0=y; r1=x
+ *   LB    load buffering      T0: r0=x; y=1       T1: r1=y; x=1
+ *   IRIW  independent reads   T0: x=1  T1: y=1    T2: r0=x; r1=y  T3: r2=y; r3=x
+ *   2+2W  write/write         T0: x=1; y=2        T1: y=1; x=2    (final x, y)
+ *   R     store/store-load    T0: x=1; y=1        T1: y=2; r0=x   (final y)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <sched.h>
+#include <unistd.h>
+#include "benchmark.h"
+
+#ifndef LITMUS_ITERS
+#define LITMUS_ITERS 1000000         // Per variant, with a CPU per thread
+#endif
+#define LITMUS_ITERS_SHARED 20000    // Per variant, when threads share CPUs
+#define BATCH 1000                   // Iterations between resets
+#define MAX_DELAY 32                 // Random pause before each body (CPU_PAUSEs)
+#define SPIN_LIMIT 4096              // Barrier spins before yielding
+#define MAX_THREADS 4
+#define MAX_REGS 4
+#define MAX_VARIANTS 4
+
+typedef struct {
+    CACHE_ALIGNED atomic_int x;
+    CACHE_ALIGNED atomic_int y;
+} loc_t;
+
+typedef void (*body_fn_t)(loc_t *l, int *r);
+
+typedef struct {
+    const char *name;
+    body_fn_t body[MAX_THREADS];
+} variant_t;
+
+typedef struct {
+    const char *name;
+    const char *description;
+    int nthreads;
+    int nregs;
+    const char *reg_names[MAX_REGS];
+    int final_x_reg;                 // Register receiving the final x, or -1
+    int final_y_reg;
+    int weak[MAX_REGS];              // The outcome SC forbids
+    variant_t variants[MAX_VARIANTS];
+} litmus_test_t;
+
+// =============================================================================
+// Test bodies, one function per (test, variant, thread)
+// =============================================================================
+
+#define ST(loc, v, mo) atomic_store_explicit(&l->loc, v, mo)
+#define LD(loc, mo) atomic_load_explicit(&l->loc, mo)
+#define FENCE() atomic_thread_fence(memory_order_seq_cst)
+#define NO_FENCE() ((void)0)
+
+#define DEF_SB(name, so, lo, fence)                                              \
+    static void sb_t0_##name(loc_t *l, int *r) { ST(x, 1, so); fence; r[0] = LD(y, lo); } \
+    static void sb_t1_##name(loc_t *l, int *r) { ST(y, 1, so); fence; r[1] = LD(x, lo); }
+
+#define DEF_MP(name, so, lo)                                                     \
+    static void mp_t0_##name(loc_t *l, int *r) { (void)r; ST(x, 1, memory_order_relaxed); ST(y, 1, so); } \
+    static void mp_t1_##name(loc_t *l, int *r) { r[0] = LD(y, lo); r[1] = LD(x, memory_order_relaxed); }
+
+#define DEF_LB(name, so, lo)                                                     \
+    static void lb_t0_##name(loc_t *l, int *r) { r[0] = LD(x, lo); ST(y, 1, so); } \
+    static void lb_t1_##name(loc_t *l, int *r) { r[1] = LD(y, lo); ST(x, 1, so); }
+
+#define DEF_IRIW(name, so, lo)                                                   \
+    static void iriw_t0_##name(loc_t *l, int *r) { (void)r; ST(x, 1, so); }       \
+    static void iriw_t1_##name(loc_t *l, int *r) { (void)r; ST(y, 1, so); }       \
+    static void iriw_t2_##name(loc_t *l, int *r) { r[0] = LD(x, lo); r[1] = LD(y, lo); } \
+    static void iriw_t3_##name(loc_t *l, int *r) { r[2] = LD(y, lo); r[3] = LD(x, lo); }
+
+#define DEF_2P2W(name, so)                                                       \
+    static void w22_t0_##name(loc_t *l, int *r) { (void)r; ST(x, 1, so); ST(y, 2, so); } \
+    static void w22_t1_##name(loc_t *l, int *r) { (void)r; ST(y, 1, so); ST(x, 2, so); }
+
+#define DEF_R(name, so, lo, fence)                                               \
+    static void r_t0_##name(loc_t *l, int *r) { (void)r; ST(x, 1, so); ST(y, 1, so); } \
+    static void r_t1_##name(loc_t *l, int *r) { ST(y, 2, so); fence; r[0] = LD(x, lo); }
+
+DEF_SB(relaxed, memory_order_relaxed, memory_order_relaxed, NO_FENCE())
+DEF_SB(relacq, memory_order_release, memory_order_acquire, NO_FENCE())
+DEF_SB(seq_cst, memory_order_seq_cst, memory_order_seq_cst, NO_FENCE())
+DEF_SB(fence, memory_order_relaxed, memory_order_relaxed, FENCE())
+DEF_MP(relaxed, memory_order_relaxed, memory_order_relaxed)
+DEF_MP(relacq, memory_order_release, memory_order_acquire)
+DEF_LB(relaxed, memory_order_relaxed, memory_order_relaxed)
+DEF_LB(relacq, memory_order_release, memory_order_acquire)
+DEF_IRIW(relaxed, memory_order_relaxed, memory_order_relaxed)
+DEF_IRIW(relacq, memory_order_release, memory_order_acquire)
+DEF_IRIW(seq_cst, memory_order_seq_cst, memory_order_seq_cst)
+DEF_2P2W(relaxed, memory_order_relaxed)
+DEF_2P2W(release, memory_order_release)
+DEF_2P2W(seq_cst, memory_order_seq_cst)
+DEF_R(relaxed, memory_order_relaxed, memory_order_relaxed, NO_FENCE())
+DEF_R(relacq, memory_order_release, memory_order_acquire, NO_FENCE())
+DEF_R(seq_cst, memory_order_seq_cst, memory_order_seq_cst, NO_FENCE())
+DEF_R(fence, memory_order_release, memory_order_relaxed, FENCE())
+
+static const litmus_test_t tests[] = {
+    { "SB", "store buffering", 2, 2, { "r0", "r1" }, -1, -1, { 0, 0 }, {
+        { "relaxed",     { sb_t0_relaxed, sb_t1_relaxed } },
+        { "rel/acq",     { sb_t0_relacq, sb_t1_relacq } },
+        { "seq_cst",     { sb_t0_seq_cst, sb_t1_seq_cst } },
+        { "+fence",      { sb_t0_fence, sb_t1_fence } } } },
+    { "MP", "message passing", 2, 2, { "r0", "r1" }, -1, -1, { 1, 0 }, {
+        { "relaxed",     { mp_t0_relaxed, mp_t1_relaxed } },
+        { "rel/acq",     { mp_t0_relacq, mp_t1_relacq } } } },
+    { "LB", "load buffering", 2, 2, { "r0", "r1" }, -1, -1, { 1, 1 }, {
+        { "relaxed",     { lb_t0_relaxed, lb_t1_relaxed } },
+        { "rel/acq",     { lb_t0_relacq, lb_t1_relacq } } } },
+    { "IRIW", "independent reads of independent writes", 4, 4,
+      { "r0", "r1", "r2", "r3" }, -1, -1, { 1, 0, 1, 0 }, {
+        { "relaxed",     { iriw_t0_relaxed, iriw_t1_relaxed, iriw_t2_relaxed, iriw_t3_relaxed } },
+        { "rel/acq",     { iriw_t0_relacq, iriw_t1_relacq, iriw_t2_relacq, iriw_t3_relacq } },
+        { "seq_cst",     { iriw_t0_seq_cst, iriw_t1_seq_cst, iriw_t2_seq_cst, iriw_t3_seq_cst } } } },
+    { "2+2W", "two writers, two locations", 2, 2, { "x", "y" }, 0, 1, { 1, 1 }, {
+        { "relaxed",     { w22_t0_relaxed, w22_t1_relaxed } },
+        { "release",     { w22_t0_release, w22_t1_release } },
+        { "seq_cst",     { w22_t0_seq_cst, w22_t1_seq_cst } } } },
+    { "R", "store then store-load", 2, 2, { "r0", "y" }, -1, 1, { 0, 2 }, {
+        { "relaxed",     { r_t0_relaxed, r_t1_relaxed } },
+        { "rel/acq",     { r_t0_relacq, r_t1_relacq } },
+        { "seq_cst",     { r_t0_seq_cst, r_t1_seq_cst } },
+        { "+fence",      { r_t0_fence, r_t1_fence } } } },
+};
+#define NUM_TESTS (int)(sizeof(tests) / sizeof(tests[0]))
+
+// =============================================================================
+// Engine
+// =============================================================================
+
+static loc_t *locs;
+static int (*regs)[MAX_REGS];
+static atomic_int *iter_sync;        // Per-iteration start barrier
+static atomic_int batch_gen = 0;     // Bumped by main to start a batch
+static atomic_int batch_done = 0;
+static atomic_int stop_flag = 0;
+static int spin_limit = SPIN_LIMIT;  // 0 when threads share CPUs
+static int *cpus;                    // CPUs in our affinity mask (cpuset)
+static atomic_int pin_failures = 0;
+static atomic_int pin_error = 0;     // errno-style code of the last failure
+
+typedef struct {
+    CACHE_ALIGNED body_fn_t body;
+    int nthreads;
+    int cpu;
+    uint32_t seed;
+} worker_arg_t;
+
+/**
+ * Spin, then yield - with fewer CPUs than threads a pure spin never ends
+ */
+static inline void wait_until_ge(atomic_int *v, int target) {
+    for (int spins = 0; atomic_load_explicit(v, memory_order_acquire) < target; spins++) {
+        if (spins < spin_limit) {
+            CPU_PAUSE();
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+void *worker(void *arg) {
+    worker_arg_t *a = arg;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(a->cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        atomic_store(&pin_error, rc);
+        atomic_fetch_add(&pin_failures, 1);
+    }
+
+    for (int gen = 1;; gen++) {
+        wait_until_ge(&batch_gen, gen);
+        if (atomic_load(&stop_flag)) {
+            break;
+        }
+        for (int i = 0; i < BATCH; i++) {
+            atomic_fetch_add_explicit(&iter_sync[i], 1, memory_order_acq_rel);
+            wait_until_ge(&iter_sync[i], a->nthreads);
+            for (uint32_t d = xorshift32(&a->seed) % MAX_DELAY; d > 0; d--) {
+                CPU_PAUSE();
+            }
+            a->body(&locs[i], regs[i]);
+        }
+        atomic_fetch_add_explicit(&batch_done, 1, memory_order_release);
+    }
+    return NULL;
+}
+
+static int outcome_key(const int *r, int nregs) {
+    int key = 0;
+    for (int k = 0; k < nregs; k++) {
+        key = key * 3 + r[k];        // Values are 0..2
+    }
+    return key;
+}
+
+/**
+ * Run one variant for iters iterations; fills hist (indexed by outcome_key)
+ */
+static void run_variant(const litmus_test_t *t, const variant_t *v, long iters,
+                        int ncpus, long *hist) {
+    pthread_t threads[MAX_THREADS];
+    worker_arg_t *args = cache_aligned_alloc(sizeof(worker_arg_t) * t->nthreads);
+
+    memset(args, 0, sizeof(worker_arg_t) * t->nthreads);
+    spin_limit = t->nthreads <= ncpus ? SPIN_LIMIT : 0;
+    atomic_store(&batch_gen, 0);
+    atomic_store(&batch_done, 0);
+    atomic_store(&stop_flag, 0);
+    for (int i = 0; i < t->nthreads; i++) {
+        args[i].body = v->body[i];
+        args[i].nthreads = t->nthreads;
+        args[i].cpu = cpus[i % ncpus];
+        args[i].seed = 0x9e3779b9u * (i + 1);
+        pthread_create(&threads[i], NULL, worker, &args[i]);
+    }
+
+    for (long done = 0, gen = 1; done < iters; done += BATCH, gen++) {
+        memset(locs, 0, sizeof(loc_t) * BATCH);
+        memset(regs, 0, sizeof(int) * MAX_REGS * BATCH);
+        for (int i = 0; i < BATCH; i++) {
+            atomic_store_explicit(&iter_sync[i], 0, memory_order_relaxed);
+        }
+        atomic_store(&batch_done, 0);
+        atomic_store_explicit(&batch_gen, (int)gen, memory_order_release);
+        wait_until_ge(&batch_done, t->nthreads);
+
+        for (int i = 0; i < BATCH; i++) {
+            if (t->final_x_reg >= 0) regs[i][t->final_x_reg] = atomic_load(&locs[i].x);
+            if (t->final_y_reg >= 0) regs[i][t->final_y_reg] = atomic_load(&locs[i].y);
+            hist[outcome_key(regs[i], t->nregs)]++;
+        }
+    }
+
+    atomic_store(&stop_flag, 1);
+    atomic_fetch_add(&batch_gen, 1);
+    for (int i = 0; i < t->nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(args);
+}
+
+static void print_test(const litmus_test_t *t, int ncpus) {
+    long iters = t->nthreads <= ncpus ? LITMUS_ITERS : LITMUS_ITERS_SHARED;
+    int nkeys = 1;
+    for (int k = 0; k < t->nregs; k++) {
+        nkeys *= 3;
+    }
+
+    printf("%s - %s (%d threads, %ld iterations per variant)\n",
+           t->name, t->description, t->nthreads, iters);
+    printf("   non-SC outcome:");
+    for (int k = 0; k < t->nregs; k++) {
+        printf(" %s=%d", t->reg_names[k], t->weak[k]);
+    }
+    printf("\n");
+
+    for (int vi = 0; vi < MAX_VARIANTS && t->variants[vi].name; vi++) {
+        long *hist = calloc(nkeys, sizeof(long));
+        run_variant(t, &t->variants[vi], iters, ncpus, hist);
+
+        long weak = hist[outcome_key(t->weak, t->nregs)];
+        printf("   %-8s %9ld non-SC (%7.4f%%) |", t->variants[vi].name, weak,
+               100.0 * weak / iters);
+        for (int key = 0; key < nkeys; key++) {
+            if (hist[key] == 0) {
+                continue;
+            }
+            int r[MAX_REGS];
+            for (int k = t->nregs - 1, rest = key; k >= 0; k--, rest /= 3) {
+                r[k] = rest % 3;
+            }
+            printf(" ");
+            for (int k = 0; k < t->nregs; k++) {
+                printf("%d", r[k]);
+            }
+            printf(":%ld%s", hist[key], key == outcome_key(t->weak, t->nregs) ? "*" : "");
+        }
+        printf("\n");
+        fflush(stdout);
+        free(hist);
+    }
+    int failed = atomic_exchange(&pin_failures, 0);
+    if (failed) {
+        printf("   ⚠️  %d thread pins failed (%s): those threads ran unpinned\n", failed,
+               strerror(atomic_load(&pin_error)));
+    }
+    printf("\n");
+}
+
+/**
+ * Collect the CPUs we may run on; returns how many. In a cpuset-restricted
+ * container they need not start at 0 or be contiguous
+ */
+static int allowed_cpus(void) {
+    cpu_set_t set;
+    int n = 0;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        perror("sched_getaffinity");
+        n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        cpus = malloc(sizeof(int) * n);
+        for (int i = 0; i < n; i++) {
+            cpus[i] = i;
+        }
+        return n;
+    }
+    cpus = malloc(sizeof(int) * CPU_COUNT(&set));
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &set)) {
+            cpus[n++] = c;
+        }
+    }
+    return n;
+}
+
+int main() {
+    int ncpus = allowed_cpus();
+
+    locs = cache_aligned_alloc(sizeof(loc_t) * BATCH);
+    regs = cache_aligned_alloc(sizeof(int) * MAX_REGS * BATCH);
+    iter_sync = cache_aligned_alloc(sizeof(atomic_int) * BATCH);
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 28: Litmus Tests - Outcome Histograms\n");
+    printf("  CPUs in affinity mask: %d, batch: %d, random delay: 0..%d pauses\n", ncpus, BATCH,
+           MAX_DELAY);
+    printf("  Histogram keys list the registers in order; * = non-SC\n");
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    for (int t = 0; t < NUM_TESTS; t++) {
+        print_test(&tests[t], ncpus);
+    }
+    free(locs);
+    free(regs);
+    free(iter_sync);
+    free(cpus);
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • x86 (TSO) only reorders a store with a LATER load: SB and\n");
+    printf("    R show non-SC outcomes unless a seq_cst store or fence\n");
+    printf("    sits between them. MP, LB, IRIW and 2+2W never do\n");
+    printf("  • ARM/POWER may show all of them for relaxed; rel/acq fixes\n");
+    printf("    MP and LB (the queue and seqlock pattern), only seq_cst\n");
+    printf("    fixes SB and IRIW\n");
+    printf("  • A non-SC count of 0 for a variant the model ALLOWS proves\n");
+    printf("    nothing - run more iterations or on more cores\n");
+    printf("  • With fewer CPUs than threads they take turns and only SC\n");
+    printf("    outcomes appear; iterations are cut to %d\n", LITMUS_ITERS_SHARED);
+    printf("\n");
+    printf("  ANALYSIS:\n");
+    printf("  make asm-28     - mfence / xchg only in the seq_cst and fence bodies\n");
+    printf("  make -B run-28 EXTRA_CFLAGS=\"-DLITMUS_ITERS=10000000\" - Longer runs\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    return 0;
+}
@@ -0,0 +1,2 @@
+// Same as main file - full implementations provided
+#include "30_asymmetric_fence.c"
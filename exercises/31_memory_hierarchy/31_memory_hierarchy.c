@@ -0,0 +1,369 @@
+/**
+ * Exercise 31: Memory Hierarchy - Latency Curve and Bandwidth
+ *
+ * Exercise 03 shows what happens when two cores fight over one line. This
+ * one measures the machine itself:
+ *
+ * Part 1 - Latency: pointer chasing through a random cyclic permutation of
+ *          cache lines (Sattolo's algorithm: one cycle through every line,
+ *          so no prefetcher can guess the next address and every load waits
+ *          for the previous one). Working sets from 4KB to MAX_WS_MB, with
+ *          4KB pages (MADV_NOHUGEPAGE) and transparent huge pages
+ *          (MADV_HUGEPAGE) - the difference past the L2 is mostly TLB misses.
+ *          Knees in the curve are detected automatically: each is the last
+ *          working set that still fit in a cache level.
+ *
+ * Part 2 - Bandwidth: the four STREAM kernels across 1..N threads
+ *            copy   c = a            scale  b = s*c
+ *            add    c = a + b        triad  a = b + s*c
+ *          on arrays far larger than the last-level cache. As STREAM
+ *          requires, each thread count gets fresh arrays first-touched in
+ *          parallel with the kernels' partition, so on a NUMA host the
+ *          pages sit next to the threads that stream them.
+ *
+ * Both parts print CSV (unindented lines) so curves from different hosts
+ * can be pasted straight into a spreadsheet.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>     // POSIX Threads API
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "benchmark.h"
+
+#ifndef MAX_WS_MB
+#define MAX_WS_MB 1024           // Largest latency working set (capped to RAM / 4)
+#endif
+#ifndef STREAM_MB
+#define STREAM_MB 64             // Per STREAM array (three arrays)
+#endif
+#define MIN_WS_KB 4
+#define CHASE_HOPS (1 << 20)     // Dependent loads timed per working set
+#define STREAM_REPEATS 5         // Keep the best, as STREAM does
+#define KNEE_RATIO 1.3           // Latency step that counts as a knee
+#define MAX_SIZES 32
+#define MAX_THREADS 64
+#define HUGE_PAGE_SIZE (2UL << 20)
+
+typedef enum { PAGES_4K, PAGES_HUGE, NUM_PAGE_MODES } page_mode_t;
+static const char *page_names[] = { "4KB pages", "huge pages" };
+
+/**
+ * mmap aligned to 2MB so THP can back it; returns NULL on failure
+ */
+static void *region_alloc(size_t bytes, page_mode_t mode, size_t *mapped) {
+    size_t len = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    char *raw = mmap(NULL, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return NULL;
+    }
+    char *p = (char *)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+    if (p > raw) {
+        munmap(raw, p - raw);
+    }
+    munmap(p + len, (raw + len + HUGE_PAGE_SIZE) - (p + len));
+    madvise(p, len, mode == PAGES_HUGE ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+    *mapped = len;
+    return p;
+}
+
+// =============================================================================
+// Part 1: pointer chasing
+// =============================================================================
+
+/**
+ * Link every line of buf into one random cycle; returns the start
+ */
+static void **build_chain(char *buf, size_t lines, uint32_t *order) {
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < lines; i++) {
+        order[i] = (uint32_t)i;
+    }
+    // Sattolo: like Fisher-Yates but j < i, which yields a single cycle
+    for (size_t i = lines - 1; i > 0; i--) {
+        size_t j = xorshift64(&seed) % i;
+        uint32_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    for (size_t i = 0; i < lines; i++) {
+        void **from = (void **)(buf + (size_t)order[i] * CACHE_LINE_SIZE);
+        *from = buf + (size_t)order[(i + 1) % lines] * CACHE_LINE_SIZE;
+    }
+    return (void **)(buf + (size_t)order[0] * CACHE_LINE_SIZE);
+}
+
+/**
+ * ns per dependent load over a working set of `bytes`; -1 if allocation failed
+ */
+static double chase_latency(size_t bytes, page_mode_t mode) {
+    size_t mapped, lines = bytes / CACHE_LINE_SIZE;
+    char *buf = region_alloc(bytes, mode, &mapped);
+    uint32_t *order = malloc(lines * sizeof(uint32_t));
+    if (buf == NULL || order == NULL) {
+        free(order);
+        return -1;
+    }
+    memset(buf, 0, bytes);                      // Fault every page in first
+    void **p = build_chain(buf, lines, order);
+    free(order);
+
+    // Warm up: one lap (or CHASE_HOPS), so small sets start cache-resident
+    long warm = lines < CHASE_HOPS ? (long)lines : CHASE_HOPS;
+    for (long i = 0; i < warm; i++) {
+        p = (void **)*p;
+    }
+    uint64_t start = get_nanos();
+    for (long i = 0; i < CHASE_HOPS; i += 8) {
+        p = (void **)*p; p = (void **)*p; p = (void **)*p; p = (void **)*p;
+        p = (void **)*p; p = (void **)*p; p = (void **)*p; p = (void **)*p;
+    }
+    uint64_t elapsed = get_nanos() - start;
+    __asm__ __volatile__("" :: "r"(p));     // Keep the chain live
+
+    munmap(buf, mapped);
+    return (double)elapsed / CHASE_HOPS;
+}
+
+/**
+ * Latency ratio of step i (sizes[i-1] -> sizes[i]); 0 off either end of the
+ * curve or if a point is missing
+ */
+static double lat_step(const double *lat, int n, int i) {
+    if (i < 1 || i >= n || lat[i - 1] <= 0 || lat[i] <= 0) {
+        return 0;
+    }
+    return lat[i] / lat[i - 1];
+}
+
+/**
+ * Print the knees: sizes after which latency jumps by >= KNEE_RATIO. Without
+ * a flat stretch between two levels the steep steps run together, so a knee
+ * is a step steeper than both neighbours: a ramp that gets gentler and then
+ * steeper again is two levels (L3, then DRAM), one that only rises and
+ * falls is one.
+ */
+static void print_knees(const size_t *sizes, const double *lat, int n, const char *label) {
+    int level = 1;
+    printf("   %s:\n", label);
+    for (int i = 1; i < n; i++) {
+        double step = lat_step(lat, n, i);
+        if (step < KNEE_RATIO || step <= lat_step(lat, n, i - 1) || step < lat_step(lat, n, i + 1)) {
+            continue;
+        }
+        printf("     knee %d: fits up to ~%zu KB (%.1f ns), then %.1f ns\n", level++,
+               sizes[i - 1] / 1024, lat[i - 1], lat[i]);
+    }
+    if (level == 1) {
+        printf("     no knee found - flat curve (try a larger MAX_WS_MB)\n");
+    }
+}
+
+// =============================================================================
+// Part 2: STREAM
+// =============================================================================
+
+typedef enum { K_COPY, K_SCALE, K_ADD, K_TRIAD, NUM_KERNELS, K_INIT = NUM_KERNELS } kernel_t;
+static const char *kernel_names[] = { "copy", "scale", "add", "triad" };
+static const int kernel_bytes[] = { 16, 16, 24, 24 };     // Per element
+
+static double *sa, *sb, *sc;
+static size_t stream_n, stream_mapped;
+
+typedef struct {
+    CACHE_ALIGNED kernel_t kernel;
+    size_t lo, hi;
+} worker_arg_t;
+
+static atomic_int ready_count = 0;
+static atomic_int start_flag = 0;
+
+void *stream_worker(void *arg) {
+    worker_arg_t *w = arg;
+    const double s = 3.0;
+    atomic_fetch_add(&ready_count, 1);
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) {
+        sched_yield();
+    }
+    switch (w->kernel) {
+    case K_INIT:
+        // First touch places each page on this thread's NUMA node
+        for (size_t i = w->lo; i < w->hi; i++) {
+            sa[i] = 1.0;
+            sb[i] = 2.0;
+            sc[i] = 0.0;
+        }
+        break;
+    case K_COPY:
+        for (size_t i = w->lo; i < w->hi; i++) sc[i] = sa[i];
+        break;
+    case K_SCALE:
+        for (size_t i = w->lo; i < w->hi; i++) sb[i] = s * sc[i];
+        break;
+    case K_ADD:
+        for (size_t i = w->lo; i < w->hi; i++) sc[i] = sa[i] + sb[i];
+        break;
+    default:
+        for (size_t i = w->lo; i < w->hi; i++) sa[i] = sb[i] + s * sc[i];
+        break;
+    }
+    return NULL;
+}
+
+/**
+ * Run kernel k on nthreads, each on its static slice; returns ns from the
+ * start signal until all have finished (thread creation is not timed)
+ */
+static uint64_t stream_launch(kernel_t k, int nthreads) {
+    pthread_t threads[MAX_THREADS];
+    worker_arg_t args[MAX_THREADS];
+    atomic_store(&ready_count, 0);
+    atomic_store(&start_flag, 0);
+    for (int t = 0; t < nthreads; t++) {
+        args[t].kernel = k;
+        args[t].lo = stream_n * t / nthreads;
+        args[t].hi = stream_n * (t + 1) / nthreads;
+        pthread_create(&threads[t], NULL, stream_worker, &args[t]);
+    }
+    while (atomic_load(&ready_count) < nthreads) {
+        sched_yield();
+    }
+    uint64_t start = get_nanos();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    for (int t = 0; t < nthreads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    return get_nanos() - start;
+}
+
+/**
+ * Fresh, untouched arrays initialized in parallel with the same partition
+ * the kernels use - STREAM's rule, so pages spread over the NUMA nodes the
+ * way the threads will access them. false if allocation failed
+ */
+static bool stream_alloc(int nthreads) {
+    size_t bytes = stream_n * sizeof(double);
+    sa = region_alloc(bytes, PAGES_4K, &stream_mapped);
+    sb = region_alloc(bytes, PAGES_4K, &stream_mapped);
+    sc = region_alloc(bytes, PAGES_4K, &stream_mapped);
+    if (!sa || !sb || !sc) {
+        return false;
+    }
+    stream_launch(K_INIT, nthreads);
+    return true;
+}
+
+static void stream_free(void) {
+    double *arrays[] = { sa, sb, sc };
+    for (int i = 0; i < 3; i++) {
+        if (arrays[i]) {
+            munmap(arrays[i], stream_mapped);
+        }
+    }
+    sa = sb = sc = NULL;
+}
+
+/**
+ * Best MB/s of STREAM_REPEATS runs of one kernel on nthreads
+ */
+static double stream_run(kernel_t k, int nthreads) {
+    double best = 0;
+    for (int r = 0; r < STREAM_REPEATS; r++) {
+        double mbps = (double)kernel_bytes[k] * stream_n / stream_launch(k, nthreads) * 1e3;
+        if (mbps > best) {
+            best = mbps;
+        }
+    }
+    return best;
+}
+
+int main() {
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t phys = (size_t)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+    size_t max_ws = (size_t)MAX_WS_MB << 20;
+    if (max_ws > phys / 4) {
+        max_ws = phys / 4;
+    }
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  Exercise 31: Memory Hierarchy - Latency and Bandwidth\n");
+    printf("  CPUs: %ld, RAM: %zu MB, sweep: %d KB .. %zu MB\n",
+           ncpus, phys >> 20, MIN_WS_KB, max_ws >> 20);
+    printf("  Reported caches: L1d %ld KB, L2 %ld KB, L3 %ld KB\n",
+           sysconf(_SC_LEVEL1_DCACHE_SIZE) / 1024, sysconf(_SC_LEVEL2_CACHE_SIZE) / 1024,
+           sysconf(_SC_LEVEL3_CACHE_SIZE) / 1024);
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    // Part 1
+    size_t sizes[MAX_SIZES];
+    double lat[NUM_PAGE_MODES][MAX_SIZES];
+    int n = 0;
+    for (size_t ws = (size_t)MIN_WS_KB << 10; ws <= max_ws && n < MAX_SIZES; ws *= 2) {
+        sizes[n++] = ws;
+    }
+
+    printf("1. Load-to-use latency, random pointer chase (ns per load)\n");
+    printf("size_kb,ns_4k_pages,ns_huge_pages\n");
+    for (int i = 0; i < n; i++) {
+        for (int m = 0; m < NUM_PAGE_MODES; m++) {
+            lat[m][i] = chase_latency(sizes[i], (page_mode_t)m);
+        }
+        printf("%zu,%.2f,%.2f\n", sizes[i] / 1024, lat[PAGES_4K][i], lat[PAGES_HUGE][i]);
+        fflush(stdout);
+    }
+    printf("\n   Knees (cache level boundaries):\n");
+    for (int m = 0; m < NUM_PAGE_MODES; m++) {
+        print_knees(sizes, lat[m], n, page_names[m]);
+    }
+
+    // Part 2
+    stream_n = ((size_t)STREAM_MB << 20) / sizeof(double);
+
+    printf("\n2. STREAM bandwidth, %d MB per array (MB/s, best of %d)\n",
+           STREAM_MB, STREAM_REPEATS);
+    printf("threads");
+    for (int k = 0; k < NUM_KERNELS; k++) {
+        printf(",%s_MBps", kernel_names[k]);
+    }
+    printf("\n");
+    int max_threads = ncpus < MAX_THREADS ? (int)ncpus : MAX_THREADS;
+    for (int t = 1; t <= max_threads; t = t * 2 > max_threads && t < max_threads ? max_threads : t * 2) {
+        if (!stream_alloc(t)) {
+            printf("%d,allocation failed\n", t);
+            stream_free();
+            break;
+        }
+        printf("%d", t);
+        for (int k = 0; k < NUM_KERNELS; k++) {
+            printf(",%.0f", stream_run((kernel_t)k, t));
+            fflush(stdout);
+        }
+        printf("\n");
+        stream_free();
+    }
+
+    printf("\n═══════════════════════════════════════════════════════════\n");
+    printf("  KEY INSIGHTS:\n");
+    printf("  • Each plateau is a cache level; the knee is its usable\n");
+    printf("    size (often a bit below the reported size)\n");
+    printf("  • Past the L2, 4KB pages add page walks to every miss: the\n");
+    printf("    huge-page curve shows the true cache/DRAM latency\n");
+    printf("  • One thread rarely saturates DRAM: bandwidth grows with\n");
+    printf("    threads until the memory controllers are busy\n");
+    printf("  • Latency bounds pointer-heavy code (lists, trees); bandwidth\n");
+    printf("    bounds streaming code - know which one you are\n");
+    printf("\n");
+    printf("  ANALYSIS:\n");
+    printf("  make -B run-31 EXTRA_CFLAGS=\"-DMAX_WS_MB=4096\" - Larger sweep\n");
+    printf("  ./exercises/31_memory_hierarchy/31_memory_hierarchy | grep '^[0-9a-z_]*,' > curve.csv\n");
+    printf("  perf stat -e dTLB-load-misses ./exercises/31_memory_hierarchy/31_memory_hierarchy\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+#ifndef ADAPTIVE_LOCK_H
+#define ADAPTIVE_LOCK_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "benchmark.h"
+#include "futex.h"
+
+// =============================================================================
+// Adaptive Spin-Then-Park Lock
+// =============================================================================
+//
+// backoff_lock() (exercise 05) spins with fixed BACKOFF_MIN/BACKOFF_MAX no
+// matter how long the lock is really held. This lock learns, per instance:
+//
+//   avg_hold_ns   EWMA of sampled hold times (measured by the holder)
+//   spin_success  EWMA of "contended acquire won while spinning" (0..1024)
+//
+// and derives the spin budget from them on every contended acquire:
+//
+//   hold > ADAPT_PARK_NS or success < ADAPT_MIN_SUCCESS → park immediately
+//   otherwise spin for ADAPT_SPIN_FACTOR * avg_hold_ns (clamped), then park
+//
+// Every ADAPT_PROBE_INTERVAL-th contended acquire spins anyway, so a lock
+// that stopped spinning can notice when spinning would pay off again.
+
+#ifndef ADAPT_PARK_NS
+#define ADAPT_PARK_NS 20000         // ~2x a futex sleep/wake round trip
+#endif
+#define ADAPT_SPIN_FACTOR 2
+#define ADAPT_SPIN_MIN_NS 200
+#define ADAPT_SPIN_MAX_NS 50000
+#define ADAPT_MIN_SUCCESS 256       // 25% in 1/1024 units
+#define ADAPT_SUCCESS_ONE 1024
+#define ADAPT_PROBE_INTERVAL 64
+#define ADAPT_SAMPLE_MASK 15        // Time 1 in 16 critical sections
+#define ADAPT_BACKOFF_MIN 4
+#define ADAPT_BACKOFF_MAX 256
+
+typedef struct {
+    atomic_int state;               // 0 free, 1 locked, 2 locked + waiters
+    atomic_uint_fast64_t avg_hold_ns;
+    atomic_uint spin_success;
+    atomic_uint_fast64_t last_budget_ns;
+    atomic_ulong spin_wins;         // Slow-path outcome counters (reporting)
+    atomic_ulong parks;             // With or without spinning first
+    // Written only by the current holder
+    uint64_t hold_start;
+    unsigned acquisitions;
+} adaptive_lock_t;
+
+static inline void adaptive_lock_init(adaptive_lock_t *l) {
+    atomic_init(&l->state, 0);
+    atomic_init(&l->avg_hold_ns, 0);
+    atomic_init(&l->spin_success, ADAPT_SUCCESS_ONE / 2);
+    atomic_init(&l->last_budget_ns, 0);
+    atomic_init(&l->spin_wins, 0);
+    atomic_init(&l->parks, 0);
+    l->hold_start = 0;
+    l->acquisitions = 0;
+}
+
+/**
+ * Spin budget for the next contended acquire (0 = park right away)
+ */
+static inline uint64_t adaptive_spin_budget(adaptive_lock_t *l, int probe) {
+    uint64_t avg = atomic_load_explicit(&l->avg_hold_ns, memory_order_relaxed);
+    unsigned success = atomic_load_explicit(&l->spin_success, memory_order_relaxed);
+
+    if (!probe && (avg > ADAPT_PARK_NS || success < ADAPT_MIN_SUCCESS)) {
+        return 0;
+    }
+    uint64_t budget = avg * ADAPT_SPIN_FACTOR;
+    if (budget < ADAPT_SPIN_MIN_NS) budget = ADAPT_SPIN_MIN_NS;
+    if (budget > ADAPT_SPIN_MAX_NS) budget = ADAPT_SPIN_MAX_NS;
+    return budget;
+}
+
+/**
+ * Feed the outcome of a spin that actually ran into spin_success. Parking
+ * without spinning says nothing about whether spinning would have won
+ */
+static inline void adaptive_record_spin(adaptive_lock_t *l, int won) {
+    // Benign read-modify-write race: the rate is a hint, not an invariant
+    unsigned s = atomic_load_explicit(&l->spin_success, memory_order_relaxed);
+    s = won ? s + (ADAPT_SUCCESS_ONE - s) / 16 : s - s / 16;
+    atomic_store_explicit(&l->spin_success, s, memory_order_relaxed);
+    if (won) {
+        atomic_fetch_add_explicit(&l->spin_wins, 1, memory_order_relaxed);
+    }
+}
+
+static inline void adaptive_lock_acquired(adaptive_lock_t *l) {
+    // Sampling keeps clock reads off most critical sections
+    l->hold_start = ((++l->acquisitions & ADAPT_SAMPLE_MASK) == 0) ? get_nanos() : 0;
+}
+
+static inline void adaptive_lock(adaptive_lock_t *l) {
+    static _Thread_local unsigned probe_tick = 0;
+    int c = 0;
+
+    if (atomic_compare_exchange_strong_explicit(
+            &l->state, &c, 1, memory_order_acquire, memory_order_relaxed)) {
+        adaptive_lock_acquired(l);
+        return;
+    }
+
+    int probe = (++probe_tick % ADAPT_PROBE_INTERVAL) == 0;
+    uint64_t budget = adaptive_spin_budget(l, probe);
+    atomic_store_explicit(&l->last_budget_ns, budget, memory_order_relaxed);
+
+    if (budget > 0) {
+        uint64_t deadline = get_nanos() + budget;
+        int backoff = ADAPT_BACKOFF_MIN;
+        do {
+            c = atomic_load_explicit(&l->state, memory_order_relaxed);
+            if (c == 0 && atomic_compare_exchange_weak_explicit(
+                    &l->state, &c, 1, memory_order_acquire, memory_order_relaxed)) {
+                adaptive_record_spin(l, 1);
+                adaptive_lock_acquired(l);
+                return;
+            }
+            for (int i = 0; i < backoff; i++) {
+                CPU_PAUSE();
+            }
+            backoff = (backoff * 2 > ADAPT_BACKOFF_MAX) ? ADAPT_BACKOFF_MAX : backoff * 2;
+        } while (get_nanos() < deadline);
+        adaptive_record_spin(l, 0);
+    }
+
+    // Park exactly like futex_mutex_lock()
+    atomic_fetch_add_explicit(&l->parks, 1, memory_order_relaxed);
+    c = atomic_exchange_explicit(&l->state, 2, memory_order_acquire);
+    while (c != 0) {
+        futex_wait(&l->state, 2);
+        c = atomic_exchange_explicit(&l->state, 2, memory_order_acquire);
+    }
+    adaptive_lock_acquired(l);
+}
+
+static inline void adaptive_unlock(adaptive_lock_t *l) {
+    if (l->hold_start != 0) {
+        uint64_t held = get_nanos() - l->hold_start;
+        uint64_t avg = atomic_load_explicit(&l->avg_hold_ns, memory_order_relaxed);
+        avg = (avg * 7 + held) / 8;
+        atomic_store_explicit(&l->avg_hold_ns, avg, memory_order_relaxed);
+    }
+    if (atomic_exchange_explicit(&l->state, 0, memory_order_release) == 2) {
+        futex_wake(&l->state, 1);
+    }
+}
+
+#endif // ADAPTIVE_LOCK_H
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <stdalign.h>
 #include <stdlib.h>
+#include <string.h>
 
 // =============================================================================
 // Timing Utilities
@@ -57,6 +58,68 @@ static inline uint64_t get_nanos(void) {
          elapsed_var = (_ts_end.tv_sec - _ts_start.tv_sec) + \
                        (_ts_end.tv_nsec - _ts_start.tv_nsec) / 1e9)
 
+/**
+ * Cheap timestamp in CPU-specific ticks (x86: RDTSC, AArch64: CNTVCT_EL0)
+ *
+ * ~10x cheaper than clock_gettime(), so it can stay inside hot loops.
+ * Ticks are NOT nanoseconds: convert with tsc_calibrate() below.
+ * Falls back to get_nanos() (1 tick = 1ns) on other architectures.
+ */
+static inline uint64_t get_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return get_nanos();
+#endif
+}
+
+/**
+ * Measure ticks per nanosecond against CLOCK_MONOTONIC (~10ms busy wait)
+ * Call once at startup and keep the result.
+ */
+static inline double tsc_calibrate(void) {
+    uint64_t ns0 = get_nanos(), t0 = get_ticks();
+    while (get_nanos() - ns0 < 10000000ULL) { }
+    uint64_t ns1 = get_nanos(), t1 = get_ticks();
+    return (double)(t1 - t0) / (double)(ns1 - ns0);
+}
+
+/**
+ * Sleep for usec microseconds (nanosleep: usleep is gone from POSIX 2008)
+ */
+static inline void sleep_for_us(long usec) {
+    struct timespec req = { .tv_sec = usec / 1000000L, .tv_nsec = (usec % 1000000L) * 1000L };
+    nanosleep(&req, NULL);
+}
+
+// =============================================================================
+// Pseudo-Random Numbers
+// =============================================================================
+
+/**
+ * Marsaglia xorshift generators: a few cycles per number and one word of
+ * state, so each thread keeps its own. The state must start non-zero.
+ */
+static inline uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static inline uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
 // =============================================================================
 // Cache-Aligned Allocation
 // =============================================================================
@@ -95,6 +158,14 @@ typedef struct {
     uint64_t count;
 } perf_counter_t;
 
+/**
+ * Raw perf_event_open(2): glibc has no wrapper. pid 0 = this thread,
+ * cpu -1 = any CPU. Returns the event fd, or -1 with errno set
+ */
+static inline int perf_event_open_attr(struct perf_event_attr *attr, pid_t pid, int cpu) {
+    return (int)syscall(__NR_perf_event_open, attr, pid, cpu, -1, 0);
+}
+
 /**
  * Initialize a perf counter
  * type: PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE, etc.
@@ -110,7 +181,7 @@ static inline int perf_counter_init(perf_counter_t *pc, uint32_t type, uint64_t
     pe.exclude_kernel = 1;
     pe.exclude_hv = 1;
     
-    pc->fd = (int)syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);
+    pc->fd = perf_event_open_attr(&pe, 0, -1);
     return pc->fd;
 }
 
@@ -164,6 +235,56 @@ static inline void perf_counter_close(perf_counter_t *pc) {
  */
 #define MEMORY_BARRIER() __sync_synchronize()
 
+/**
+ * Asymmetric fence pair (Linux membarrier(2), MEMBARRIER_CMD_PRIVATE_EXPEDITED)
+ *
+ * For Dekker-style handshakes where one side runs constantly (readers
+ * publishing a hazard, then re-checking) and the other rarely (a writer
+ * publishing, then scanning). The fast side uses ASYM_FENCE_LIGHT() - only
+ * a compiler barrier; the slow side calls asym_fence_heavy(), which makes
+ * the kernel run a full barrier on every CPU currently running one of our
+ * threads. Together they order like a MEMORY_BARRIER() on each side.
+ *
+ * Call asym_fence_init() once before starting threads. Without membarrier
+ * (old kernel, not Linux, blocked by seccomp) both sides fall back to
+ * MEMORY_BARRIER(), so the pairing stays correct - just not cheaper.
+ */
+#ifdef __linux__
+#include <linux/membarrier.h>
+#endif
+
+static int asym_fence_expedited = 0;
+
+/**
+ * Register for expedited private membarrier; returns 1 if available
+ */
+static inline int asym_fence_init(void) {
+#if defined(__linux__) && defined(__NR_membarrier)
+    long cmds = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+    if (cmds > 0 && (cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED) &&
+        syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0) {
+        asym_fence_expedited = 1;
+    }
+#endif
+    return asym_fence_expedited;
+}
+
+#define ASYM_FENCE_LIGHT()                                              \
+    do {                                                                \
+        if (asym_fence_expedited) COMPILER_BARRIER();                   \
+        else MEMORY_BARRIER();                                          \
+    } while (0)
+
+static inline void asym_fence_heavy(void) {
+#if defined(__linux__) && defined(__NR_membarrier)
+    if (asym_fence_expedited &&
+        syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) == 0) {
+        return;
+    }
+#endif
+    MEMORY_BARRIER();
+}
+
 /**
  * CPU pause instruction (for spin loops)
  */
@@ -224,4 +345,95 @@ static inline void stats_print(const stats_t *s, const char *label) {
            s->count);
 }
 
+/**
+ * Log-linear histogram (HdrHistogram-style, buckets up to 25% wide)
+ *
+ * Each power of two is split into 2^HIST_SUB_BITS linear sub-buckets, so
+ * one fixed-size array covers 0..2^64 with bounded relative error: with 4
+ * sub-buckets a bucket spans at most 25% of its lower bound, and a
+ * percentile (reported as that lower bound) reads up to 20% low. Adding a
+ * sample is a CLZ and an increment - cheap enough for per-operation use.
+ */
+#define HIST_SUB_BITS 2
+#define HIST_SUB_COUNT (1u << HIST_SUB_BITS)
+#define HIST_BUCKETS (64 * HIST_SUB_COUNT)
+
+typedef struct {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} hist_t;
+
+static inline void hist_init(hist_t *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+static inline unsigned hist_bucket(uint64_t v) {
+    if (v < HIST_SUB_COUNT) return (unsigned)v;
+    unsigned msb = 63 - (unsigned)__builtin_clzll(v);
+    unsigned shift = msb - HIST_SUB_BITS;
+    return ((msb - HIST_SUB_BITS + 1) << HIST_SUB_BITS) |
+           (unsigned)((v >> shift) & (HIST_SUB_COUNT - 1));
+}
+
+/** Smallest value that lands in bucket b */
+static inline uint64_t hist_bucket_low(unsigned b) {
+    if (b < HIST_SUB_COUNT) return b;
+    unsigned msb = (b >> HIST_SUB_BITS) - 1 + HIST_SUB_BITS;
+    uint64_t sub = b & (HIST_SUB_COUNT - 1);
+    return (1ULL << msb) | (sub << (msb - HIST_SUB_BITS));
+}
+
+static inline void hist_add(hist_t *h, uint64_t v) {
+    h->counts[hist_bucket(v)]++;
+    h->total++;
+    if (v > h->max) h->max = v;
+}
+
+static inline void hist_merge(hist_t *dst, const hist_t *src) {
+    for (unsigned b = 0; b < HIST_BUCKETS; b++) {
+        dst->counts[b] += src->counts[b];
+    }
+    dst->total += src->total;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+/**
+ * Value at percentile p (0..100), reported as the bucket's lower bound
+ */
+static inline uint64_t hist_percentile(const hist_t *h, double p) {
+    if (h->total == 0) return 0;
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)h->total);
+    if (rank >= h->total) return h->max;
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < HIST_BUCKETS; b++) {
+        seen += h->counts[b];
+        if (seen > rank) return hist_bucket_low(b);
+    }
+    return h->max;
+}
+
+/**
+ * Print one bar per power of two; scale converts raw units to `unit`
+ */
+static inline void hist_print(const hist_t *h, const char *label,
+                              double scale, const char *unit) {
+    uint64_t per_pow[65] = {0};
+    printf("%s (n=%lu)\n", label, (unsigned long)h->total);
+    if (h->total == 0) return;
+    for (unsigned b = 0; b < HIST_BUCKETS; b++) {
+        uint64_t low = hist_bucket_low(b);
+        per_pow[low ? 64 - __builtin_clzll(low) : 0] += h->counts[b];
+    }
+    for (unsigned e = 0; e <= 64; e++) {
+        if (per_pow[e] == 0) continue;
+        double lo = e ? (double)(1ULL << (e - 1)) : 0.0;
+        int bar = (int)(40.0 * (double)per_pow[e] / (double)h->total + 0.5);
+        printf("  %10.0f - %-10.0f %-3s |%-40.*s| %5.1f%%\n",
+               lo * scale, (e ? lo * 2 : 1.0) * scale, unit, bar,
+               "########################################",
+               100.0 * (double)per_pow[e] / (double)h->total);
+    }
+}
+
 #endif // BENCHMARK_H
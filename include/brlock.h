@@ -0,0 +1,121 @@
+#ifndef BRLOCK_H
+#define BRLOCK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <sched.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Big-Reader Lock - Distributed Reader Indicators
+// =============================================================================
+//
+// pthread_rwlock_rdlock() does an atomic RMW on ONE reader count: with 64
+// readers that line bounces between 64 caches and reads stop scaling long
+// before the critical section is the bottleneck.
+//
+// A big-reader lock (Linux br_lock, "distributed rwlock") gives every
+// reader slot its own padded counter:
+//
+//   reader:  slot[me]++  ->  writer flag clear? enter : slot[me]--, wait
+//   writer:  writer flag = 1  ->  wait until EVERY slot is 0
+//
+// Readers only write their own line (it stays in their cache); writers pay
+// O(slots) to scan. Good when reads vastly outnumber writes.
+//
+// The reader increment and the writer flag form a Dekker-style handshake
+// (store, then load the other side's variable): both sides use seq_cst so
+// the store can't be reordered after the load.
+//
+// Slots are per thread (round-robin on first use). Build with -DBR_PER_CPU
+// to index by sched_getcpu() instead; the reader keeps the slot it locked
+// so migrating mid-section is harmless.
+
+#define BR_MAX_SLOTS 64
+#define BR_SPINS_BEFORE_YIELD 256   // Waiters yield: readers may be descheduled
+
+typedef struct {
+    CACHE_ALIGNED atomic_int readers;
+} br_slot_t;
+
+typedef struct {
+    CACHE_ALIGNED atomic_bool writer;
+    br_slot_t slots[BR_MAX_SLOTS];
+} br_rwlock_t;
+
+#define BR_RWLOCK_INITIALIZER { 0 }
+
+#ifndef BR_PER_CPU
+static atomic_int br_next_slot = 0;
+static __thread int br_thread_slot = -1;
+#endif
+
+/**
+ * This thread's reader slot
+ */
+static inline int br_slot(void) {
+#ifdef BR_PER_CPU
+    int cpu = sched_getcpu();
+    return (cpu < 0 ? 0 : cpu) % BR_MAX_SLOTS;
+#else
+    if (br_thread_slot < 0) {
+        br_thread_slot = atomic_fetch_add(&br_next_slot, 1) % BR_MAX_SLOTS;
+    }
+    return br_thread_slot;
+#endif
+}
+
+static inline void br_wait_pause(int *spins) {
+    if (++*spins < BR_SPINS_BEFORE_YIELD) {
+        CPU_PAUSE();
+    } else {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+/**
+ * Enter a read section; pass the returned slot to br_read_unlock()
+ */
+static inline int br_read_lock(br_rwlock_t *l) {
+    int slot = br_slot();
+    atomic_int *mine = &l->slots[slot].readers;
+    for (;;) {
+        atomic_fetch_add(mine, 1);                  // seq_cst: announce first
+        if (!atomic_load(&l->writer)) {             // ... then look
+            return slot;
+        }
+        atomic_fetch_sub_explicit(mine, 1, memory_order_relaxed);
+        int spins = 0;
+        while (atomic_load_explicit(&l->writer, memory_order_relaxed)) {
+            br_wait_pause(&spins);
+        }
+    }
+}
+
+static inline void br_read_unlock(br_rwlock_t *l, int slot) {
+    atomic_fetch_sub_explicit(&l->slots[slot].readers, 1, memory_order_release);
+}
+
+static inline void br_write_lock(br_rwlock_t *l) {
+    int spins = 0;
+    for (;;) {
+        while (atomic_load_explicit(&l->writer, memory_order_relaxed)) {
+            br_wait_pause(&spins);
+        }
+        if (!atomic_exchange(&l->writer, true)) {   // seq_cst: flag first
+            break;
+        }
+    }
+    for (int i = 0; i < BR_MAX_SLOTS; i++) {        // ... then drain readers
+        while (atomic_load(&l->slots[i].readers) != 0) {
+            br_wait_pause(&spins);
+        }
+    }
+}
+
+static inline void br_write_unlock(br_rwlock_t *l) {
+    atomic_store_explicit(&l->writer, false, memory_order_release);
+}
+
+#endif // BRLOCK_H
@@ -0,0 +1,164 @@
+#ifndef DELEGATION_H
+#define DELEGATION_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Delegation: a Server Thread Runs Every Critical Section
+// =============================================================================
+//
+// Even a perfect queue lock (MCS) moves the PROTECTED DATA to the next
+// holder's cache on every acquire. Delegation (ffwd, Roghanchi et al.,
+// SOSP 2017) never moves it: one dedicated server thread owns the data and
+// clients ship it closures instead.
+//
+//   client i:  request line  {fn, arg, toggle}     written by client only
+//   server:    response line {results[7], done}    written by server only
+//
+// A client flips its toggle to post a request and spins until its bit in
+// the group's `done` word matches. The server sweeps all request lines,
+// runs the new ones, and writes each group's 7 results + done bits back
+// with one store per line - responses are batched, not one line per call.
+//
+// Usage:
+//   static deleg_server_t srv;
+//   deleg_start(&srv, &shared_state);
+//   long r = deleg_call(&srv, client_id, fn, arg);  // client_id < DELEG_MAX_CLIENTS
+//   deleg_stop(&srv);
+
+#define DELEG_MAX_CLIENTS 63
+#define DELEG_GROUP 7                   // Responses per cache line
+#define DELEG_GROUPS ((DELEG_MAX_CLIENTS + DELEG_GROUP - 1) / DELEG_GROUP)
+#define DELEG_SPINS_BEFORE_YIELD 256    // Don't starve the other side of a
+                                        // shared core (threads > CPUs)
+
+typedef long (*deleg_fn_t)(void *state, long arg);
+
+typedef struct {
+    CACHE_ALIGNED deleg_fn_t fn;
+    long arg;
+    atomic_uint toggle;                 // Flipped by client to post
+} deleg_request_t;
+
+typedef struct {
+    CACHE_ALIGNED long results[DELEG_GROUP];
+    atomic_uint done;                   // Bit i = toggle of last completed call
+} deleg_response_t;
+
+typedef struct {
+    void *state;
+    pthread_t thread;
+    atomic_int stop;
+    atomic_int nclients;                // Highest client id seen + 1
+    unsigned long sweeps;               // Non-empty sweeps (server-only)
+    unsigned long served;
+    deleg_request_t requests[DELEG_MAX_CLIENTS];
+    deleg_response_t responses[DELEG_GROUPS];
+} deleg_server_t;
+
+/**
+ * One pass over all clients; returns how many requests were served
+ */
+static inline int deleg_sweep(deleg_server_t *srv) {
+    int n = atomic_load_explicit(&srv->nclients, memory_order_acquire);
+    int served = 0;
+
+    for (int g = 0; g * DELEG_GROUP < n; g++) {
+        deleg_response_t *resp = &srv->responses[g];
+        unsigned done = atomic_load_explicit(&resp->done, memory_order_relaxed);
+        unsigned new_done = done;
+        long results[DELEG_GROUP];
+
+        for (int i = 0; i < DELEG_GROUP && g * DELEG_GROUP + i < n; i++) {
+            deleg_request_t *req = &srv->requests[g * DELEG_GROUP + i];
+            unsigned t = atomic_load_explicit(&req->toggle, memory_order_acquire);
+            if (t != ((done >> i) & 1u)) {
+                results[i] = req->fn(srv->state, req->arg);
+                new_done ^= 1u << i;
+            }
+        }
+        if (new_done != done) {
+            // One burst of writes to one line, then publish all of them
+            for (int i = 0; i < DELEG_GROUP; i++) {
+                if ((new_done ^ done) & (1u << i)) {
+                    resp->results[i] = results[i];
+                    served++;
+                }
+            }
+            atomic_store_explicit(&resp->done, new_done, memory_order_release);
+        }
+    }
+    return served;
+}
+
+static inline void *deleg_server_main(void *arg) {
+    deleg_server_t *srv = arg;
+    int idle = 0;
+    while (!atomic_load_explicit(&srv->stop, memory_order_relaxed)) {
+        int served = deleg_sweep(srv);
+        if (served > 0) {
+            srv->sweeps++;
+            srv->served += served;
+            idle = 0;
+        } else if (++idle >= DELEG_SPINS_BEFORE_YIELD) {
+            idle = 0;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static inline int deleg_start(deleg_server_t *srv, void *state) {
+    memset(srv, 0, sizeof(*srv));
+    srv->state = state;
+    return pthread_create(&srv->thread, NULL, deleg_server_main, srv);
+}
+
+/**
+ * Stop and join the server; all clients must have returned from deleg_call()
+ */
+static inline void deleg_stop(deleg_server_t *srv) {
+    atomic_store_explicit(&srv->stop, 1, memory_order_relaxed);
+    pthread_join(srv->thread, NULL);
+}
+
+/**
+ * Have the server run fn(state, arg); blocks until the result is back
+ */
+static inline long deleg_call(deleg_server_t *srv, int client, deleg_fn_t fn, long arg) {
+    deleg_request_t *req = &srv->requests[client];
+    deleg_response_t *resp = &srv->responses[client / DELEG_GROUP];
+    unsigned bit = 1u << (client % DELEG_GROUP);
+
+    int n = atomic_load_explicit(&srv->nclients, memory_order_relaxed);
+    while (client >= n && !atomic_compare_exchange_weak_explicit(
+               &srv->nclients, &n, client + 1,
+               memory_order_release, memory_order_relaxed)) {
+    }
+
+    unsigned t = atomic_load_explicit(&req->toggle, memory_order_relaxed) ^ 1u;
+    req->fn = fn;
+    req->arg = arg;
+    atomic_store_explicit(&req->toggle, t, memory_order_release);
+
+    int spins = 0;
+    while (((atomic_load_explicit(&resp->done, memory_order_acquire) & bit) != 0) != t) {
+        if (++spins >= DELEG_SPINS_BEFORE_YIELD) {
+            spins = 0;
+            sched_yield();
+        }
+        CPU_PAUSE();
+    }
+    return resp->results[client % DELEG_GROUP];
+}
+
+/** Average requests served per non-empty sweep */
+static inline double deleg_batch_size(const deleg_server_t *srv) {
+    return srv->sweeps ? (double)srv->served / (double)srv->sweeps : 0.0;
+}
+
+#endif // DELEGATION_H
@@ -0,0 +1,210 @@
+#ifndef EBR_H
+#define EBR_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Epoch-Based Reclamation (EBR)
+// =============================================================================
+//
+// A lock-free structure can unlink a node while another thread is still
+// reading it: free() it now and that reader touches freed memory. EBR
+// (Fraser, "Practical lock-freedom") defers the free:
+//
+//   ebr_enter()          announce "active in global epoch E"
+//   ... load shared pointers, use nodes ...
+//   ebr_retire(node)     unlinked: goes on a limbo list stamped with the
+//                        GLOBAL epoch G read after the unlink
+//   ebr_exit()           announce "inactive"
+//
+// The global epoch only moves E -> E+1 once every ACTIVE thread has
+// announced E. A region that could still see the node started before the
+// unlink, so it announced G or earlier (a thread may lag one behind: the
+// epoch can move while it sits in a region). The step G+1 -> G+2 needs every
+// active thread at G+1, so once the epoch reaches G+2 those regions are
+// gone: limbo list G can be freed. Three lists (G mod 3) suffice.
+//
+// Stamping with the thread's own announced epoch instead would be one step
+// short: it can be G-1, and the list would go at G+1 while a region that
+// entered at G still reads the node.
+//
+// Advancing scans all threads, so it is amortized: a thread tries every
+// EBR_ADVANCE_EVERY retires. Each thread frees its own limbo lists when it
+// sees the epoch move, so no free() ever races with another thread.
+//
+// Weakness: one thread stalled inside a region stops the epoch, and with it
+// ALL reclamation (compare hazard pointers). Keep regions short.
+//
+// Retired objects embed an ebr_node_t (intrusive, like rcu_head_t) - no
+// allocation on the retire path.
+
+#define EBR_MAX_THREADS 64
+#define EBR_EPOCHS 3
+#define EBR_ADVANCE_EVERY 64
+#define EBR_SPINS_BEFORE_YIELD 256
+
+typedef struct ebr_node {
+    struct ebr_node *next;
+    void (*free_fn)(struct ebr_node *node);
+} ebr_node_t;
+
+typedef struct {
+    ebr_node_t *head;
+    unsigned long epoch;            // Epoch these nodes were retired in
+    unsigned long count;
+} ebr_limbo_t;
+
+typedef struct {
+    CACHE_ALIGNED atomic_ulong local;   // epoch << 1 | active
+    // Private to the owning thread:
+    unsigned long seen_epoch;
+    unsigned long since_advance;
+    ebr_limbo_t limbo[EBR_EPOCHS];
+    unsigned long retired, freed;
+    int index;
+} ebr_thread_t;
+
+typedef struct {
+    CACHE_ALIGNED atomic_ulong epoch;
+    atomic_ulong advances;
+    _Atomic(ebr_thread_t *) threads[EBR_MAX_THREADS];
+} ebr_domain_t;
+
+#define EBR_DOMAIN_INITIALIZER { 0 }
+
+static inline void ebr_register(ebr_domain_t *d, ebr_thread_t *t) {
+    memset(t, 0, sizeof(*t));
+    for (int i = 0; i < EBR_MAX_THREADS; i++) {
+        ebr_thread_t *expected = NULL;
+        if (atomic_compare_exchange_strong(&d->threads[i], &expected, t)) {
+            t->index = i;
+            return;
+        }
+    }
+    fprintf(stderr, "ebr: more than %d threads\n", EBR_MAX_THREADS);
+    abort();
+}
+
+static inline void ebr_free_limbo(ebr_thread_t *t, ebr_limbo_t *l) {
+    ebr_node_t *n = l->head;
+    while (n) {
+        ebr_node_t *next = n->next;
+        n->free_fn(n);
+        n = next;
+    }
+    t->freed += l->count;
+    l->head = NULL;
+    l->count = 0;
+}
+
+/**
+ * Free every limbo list retired two or more epochs before `epoch`
+ */
+static inline void ebr_collect(ebr_thread_t *t, unsigned long epoch) {
+    for (int i = 0; i < EBR_EPOCHS; i++) {
+        if (t->limbo[i].head && t->limbo[i].epoch + 2 <= epoch) {
+            ebr_free_limbo(t, &t->limbo[i]);
+        }
+    }
+    t->seen_epoch = epoch;
+}
+
+/**
+ * Advance the global epoch if every active thread has caught up with it
+ */
+static inline bool ebr_try_advance(ebr_domain_t *d) {
+    unsigned long e = atomic_load(&d->epoch);
+    for (int i = 0; i < EBR_MAX_THREADS; i++) {
+        ebr_thread_t *t = atomic_load_explicit(&d->threads[i], memory_order_acquire);
+        if (t == NULL) {
+            continue;
+        }
+        unsigned long l = atomic_load(&t->local);
+        if ((l & 1) && (l >> 1) != e) {
+            return false;               // Someone is still in an older epoch
+        }
+    }
+    if (atomic_compare_exchange_strong(&d->epoch, &e, e + 1)) {
+        atomic_fetch_add_explicit(&d->advances, 1, memory_order_relaxed);
+    }
+    return true;
+}
+
+/**
+ * Enter a protected region: pointers loaded from here on stay valid
+ */
+static inline void ebr_enter(ebr_domain_t *d, ebr_thread_t *t) {
+    unsigned long e = atomic_load(&d->epoch);
+    // seq_cst store then load: the announcement is visible before we load
+    // any shared pointer (a release store alone could pass the loads)
+    atomic_store(&t->local, e << 1 | 1);
+    unsigned long now = atomic_load(&d->epoch);
+    if (now != e) {
+        e = now;                        // Moved meanwhile: don't hold it back
+        atomic_store(&t->local, e << 1 | 1);
+    }
+    if (e != t->seen_epoch) {
+        ebr_collect(t, e);
+    }
+}
+
+static inline void ebr_exit(ebr_thread_t *t) {
+    unsigned long l = atomic_load_explicit(&t->local, memory_order_relaxed);
+    atomic_store_explicit(&t->local, l & ~1UL, memory_order_release);
+}
+
+/**
+ * Hand an unlinked node to EBR; call inside a region. free_fn runs later,
+ * on this thread, once no region that could have seen the node remains.
+ */
+static inline void ebr_retire(ebr_domain_t *d, ebr_thread_t *t, ebr_node_t *node,
+                              void (*free_fn)(ebr_node_t *node)) {
+    // seq_cst: ordered after the caller's unlink (as in crossbeam-epoch)
+    unsigned long e = atomic_load(&d->epoch);
+    ebr_limbo_t *l = &t->limbo[e % EBR_EPOCHS];
+    if (l->head && l->epoch != e) {
+        ebr_free_limbo(t, l);           // Stamped e-3 or older, epoch is e: safe
+    }
+    node->free_fn = free_fn;
+    node->next = l->head;
+    l->head = node;
+    l->epoch = e;
+    l->count++;
+    t->retired++;
+    if (++t->since_advance >= EBR_ADVANCE_EVERY) {
+        t->since_advance = 0;
+        ebr_try_advance(d);
+    }
+}
+
+/**
+ * Objects retired but not yet freed by this thread
+ */
+static inline unsigned long ebr_pending(const ebr_thread_t *t) {
+    return t->retired - t->freed;
+}
+
+/**
+ * Leave the domain: keeps advancing the epoch until all of this thread's
+ * retired nodes are freed, then releases the slot. Not inside a region.
+ */
+static inline void ebr_unregister(ebr_domain_t *d, ebr_thread_t *t) {
+    int spins = 0;
+    while (ebr_pending(t) > 0) {
+        ebr_try_advance(d);
+        ebr_collect(t, atomic_load(&d->epoch));
+        if (++spins >= EBR_SPINS_BEFORE_YIELD) {
+            spins = 0;
+            sched_yield();              // Let stragglers leave their regions
+        }
+    }
+    atomic_store(&d->threads[t->index], NULL);
+}
+
+#endif // EBR_H
@@ -0,0 +1,171 @@
+#ifndef ELISION_H
+#define ELISION_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "benchmark.h"
+#include "spinlock.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define ELISION_X86 1
+#endif
+
+// =============================================================================
+// Lock Elision (Intel TSX / RTM) with TTAS Fallback
+// =============================================================================
+//
+// Readers of a read-mostly structure serialize on a TTAS lock even though
+// they never conflict. Lock elision runs the critical section as a hardware
+// transaction WITHOUT taking the lock:
+//
+//   _xbegin()                 start transaction (reads/writes tracked in L1)
+//   read lock word            lock goes into the read set: if anyone takes
+//                             the lock for real, we abort automatically
+//   ... critical section ...
+//   _xend()                   commit atomically - nobody ever "held" the lock
+//
+// Two threads only serialize if their critical sections touch the same
+// cache line with at least one write. After ELISION_MAX_RETRIES aborts (or
+// one abort the hardware says won't succeed on retry) we take the TTAS lock
+// normally.
+//
+// RTM is checked at runtime with CPUID. Most CPUs since 2019 ship with TSX
+// disabled by microcode, and non-x86 has none: elided_lock() then IS
+// ttas_lock(), so code using it builds and runs everywhere.
+//
+// Statistics are per thread (elision_stats_t, padded) - a shared counter
+// written inside or right after a transaction would itself cause conflicts.
+
+#ifndef ELISION_MAX_RETRIES
+#define ELISION_MAX_RETRIES 3
+#endif
+#define ELISION_XABORT_LOCK_BUSY 0xff   // Our _xabort() code: lock was held
+
+typedef enum {
+    ELISION_ABORT_CONFLICT,     // Another core touched our read/write set
+    ELISION_ABORT_CAPACITY,     // Transaction footprint exceeded L1/buffers
+    ELISION_ABORT_LOCK_BUSY,    // Lock was taken for real (explicit abort)
+    ELISION_ABORT_EXPLICIT,     // Other _xabort() codes
+    ELISION_ABORT_OTHER,        // Interrupt, syscall, page fault, debug...
+    ELISION_ABORT_KINDS
+} elision_abort_t;
+
+static inline const char *elision_abort_name(elision_abort_t why) {
+    switch (why) {
+    case ELISION_ABORT_CONFLICT:  return "conflict";
+    case ELISION_ABORT_CAPACITY:  return "capacity";
+    case ELISION_ABORT_LOCK_BUSY: return "lock busy";
+    case ELISION_ABORT_EXPLICIT:  return "explicit";
+    default:                      return "other";
+    }
+}
+
+typedef struct {
+    CACHE_ALIGNED unsigned long commits;    // Critical sections run elided
+    unsigned long fallbacks;                // ... and run under the real lock
+    unsigned long aborts[ELISION_ABORT_KINDS];
+    bool in_tx;                             // Current section is elided
+} elision_stats_t;
+
+typedef struct {
+    ttas_spinlock_t lock;
+} elided_lock_t;
+
+#define ELIDED_LOCK_INITIALIZER { TTAS_SPINLOCK_INITIALIZER }
+
+/**
+ * Does this CPU (and kernel/microcode) support RTM? Cached after first call.
+ */
+static inline bool elision_rtm_supported(void) {
+#ifdef ELISION_X86
+    static int cached = -1;
+    if (cached < 0) {
+        unsigned eax, ebx, ecx, edx;
+        // CPUID.(EAX=7,ECX=0): EBX bit 11 = RTM, EDX bit 11 = RTM_ALWAYS_ABORT
+        cached = __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) &&
+                 (ebx & (1u << 11)) != 0 && (edx & (1u << 11)) == 0;
+    }
+    return cached;
+#else
+    return false;
+#endif
+}
+
+#ifdef ELISION_X86
+static inline elision_abort_t elision_classify(unsigned status) {
+    if (status & _XABORT_EXPLICIT) {
+        return _XABORT_CODE(status) == ELISION_XABORT_LOCK_BUSY
+               ? ELISION_ABORT_LOCK_BUSY : ELISION_ABORT_EXPLICIT;
+    }
+    if (status & _XABORT_CONFLICT) return ELISION_ABORT_CONFLICT;
+    if (status & _XABORT_CAPACITY) return ELISION_ABORT_CAPACITY;
+    return ELISION_ABORT_OTHER;
+}
+
+/**
+ * Try to start an elided critical section; true = running transactionally
+ */
+__attribute__((target("rtm")))
+static inline bool elision_try_begin(elided_lock_t *l, elision_stats_t *st) {
+    for (int attempt = 0; attempt < ELISION_MAX_RETRIES; attempt++) {
+        // Don't start a transaction that would abort on the lock word anyway
+        while (atomic_load_explicit(&l->lock.locked, memory_order_relaxed)) {
+            CPU_PAUSE();
+        }
+        unsigned status = _xbegin();
+        if (status == _XBEGIN_STARTED) {
+            if (atomic_load_explicit(&l->lock.locked, memory_order_relaxed)) {
+                _xabort(ELISION_XABORT_LOCK_BUSY);
+            }
+            return true;
+        }
+        elision_abort_t why = elision_classify(status);
+        st->aborts[why]++;
+        // Capacity/other aborts without the RETRY hint will just happen again
+        if (why != ELISION_ABORT_LOCK_BUSY && !(status & _XABORT_RETRY)) {
+            break;
+        }
+    }
+    return false;
+}
+
+__attribute__((target("rtm")))
+static inline void elision_commit(void) {
+    _xend();
+}
+#endif
+
+static inline void elided_lock(elided_lock_t *l, elision_stats_t *st) {
+#ifdef ELISION_X86
+    if (elision_rtm_supported() && elision_try_begin(l, st)) {
+        st->in_tx = true;
+        return;
+    }
+#endif
+    ttas_lock(&l->lock);
+    st->in_tx = false;
+}
+
+static inline void elided_unlock(elided_lock_t *l, elision_stats_t *st) {
+#ifdef ELISION_X86
+    if (st->in_tx) {
+        elision_commit();
+        st->commits++;
+        return;
+    }
+#endif
+    ttas_unlock(&l->lock);
+    st->fallbacks++;
+}
+
+static inline void elision_stats_merge(elision_stats_t *dst, const elision_stats_t *src) {
+    dst->commits += src->commits;
+    dst->fallbacks += src->fallbacks;
+    for (int i = 0; i < ELISION_ABORT_KINDS; i++) {
+        dst->aborts[i] += src->aborts[i];
+    }
+}
+
+#endif // ELISION_H
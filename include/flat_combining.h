@@ -0,0 +1,130 @@
+#ifndef FLAT_COMBINING_H
+#define FLAT_COMBINING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Flat Combining (Hendler, Incze, Shavit, Tzafrir - SPAA 2010)
+// =============================================================================
+//
+// With a plain lock every operation pays one full hand-off: the lock line
+// AND the protected data migrate to the next holder's cache. When the work
+// itself is tiny (counter++, push, pop) the hand-off IS the cost.
+//
+// Flat combining turns N hand-offs into one:
+//
+//   1. Publish: write {op, arg} into YOUR padded slot, set pending = 1
+//   2. If the lock is free, take it and become the combiner: scan every slot,
+//      run each pending op against the shared state, write the result back
+//      and clear pending. Release.
+//   3. Otherwise spin on your own slot until some combiner clears pending.
+//
+// The shared state only ever lives in the combiner's cache, and waiters spin
+// on their own line instead of the lock's.
+//
+// Usage:
+//   static fc_lock_t fc;
+//   fc_init(&fc, &shared_counter);
+//   long old = fc_apply(&fc, tid, fc_op_add, 1);   // tid in 0..FC_MAX_THREADS-1
+
+#define FC_MAX_THREADS 64
+#define FC_COMBINE_PASSES 2     // Rescan while it keeps finding work
+
+typedef long (*fc_op_t)(void *state, long arg);
+
+typedef struct {
+    CACHE_ALIGNED atomic_int pending;   // 1 = request posted, 0 = served
+    fc_op_t op;
+    long arg;
+    long result;
+} fc_slot_t;
+
+typedef struct {
+    CACHE_ALIGNED atomic_bool locked;
+    atomic_int nslots;                  // Highest tid seen + 1 (scan bound)
+    void *state;
+    unsigned long passes;               // Combiner-only statistics
+    unsigned long combined;
+    fc_slot_t slots[FC_MAX_THREADS];
+} fc_lock_t;
+
+static inline void fc_init(fc_lock_t *fc, void *state) {
+    memset(fc, 0, sizeof(*fc));
+    fc->state = state;
+}
+
+/**
+ * Combiner pass: serve every pending slot (caller holds fc->locked)
+ */
+static inline void fc_combine(fc_lock_t *fc) {
+    int n = atomic_load_explicit(&fc->nslots, memory_order_acquire);
+    for (int pass = 0; pass < FC_COMBINE_PASSES; pass++) {
+        int served = 0;
+        for (int i = 0; i < n; i++) {
+            fc_slot_t *s = &fc->slots[i];
+            if (atomic_load_explicit(&s->pending, memory_order_acquire)) {
+                s->result = s->op(fc->state, s->arg);
+                atomic_store_explicit(&s->pending, 0, memory_order_release);
+                served++;
+            }
+        }
+        if (served > 0) {
+            fc->passes++;
+            fc->combined += served;
+        }
+        if (served <= 1) break;  // Only ourselves: nobody to batch with
+    }
+}
+
+/**
+ * Run op(state, arg) under mutual exclusion; returns op's result
+ */
+static inline long fc_apply(fc_lock_t *fc, int tid, fc_op_t op, long arg) {
+    fc_slot_t *s = &fc->slots[tid];
+
+    int n = atomic_load_explicit(&fc->nslots, memory_order_relaxed);
+    while (tid >= n && !atomic_compare_exchange_weak_explicit(
+               &fc->nslots, &n, tid + 1,
+               memory_order_release, memory_order_relaxed)) {
+    }
+
+    s->op = op;
+    s->arg = arg;
+    atomic_store_explicit(&s->pending, 1, memory_order_release);
+
+    while (1) {
+        if (!atomic_load_explicit(&s->pending, memory_order_acquire)) {
+            return s->result;  // A combiner did our work
+        }
+        if (!atomic_load_explicit(&fc->locked, memory_order_relaxed)) {
+            bool expected = false;
+            if (atomic_compare_exchange_weak_explicit(
+                    &fc->locked, &expected, true,
+                    memory_order_acquire, memory_order_relaxed)) {
+                fc_combine(fc);  // Serves our own slot too
+                atomic_store_explicit(&fc->locked, false, memory_order_release);
+                return s->result;
+            }
+        }
+        CPU_PAUSE();
+    }
+}
+
+/**
+ * Combining counter op: *(long *)state += arg, returns the old value
+ */
+static inline long fc_op_add(void *state, long arg) {
+    long *counter = state;
+    long old = *counter;
+    *counter = old + arg;
+    return old;
+}
+
+/** Average requests served per combiner pass (1.0 = no combining) */
+static inline double fc_batch_size(const fc_lock_t *fc) {
+    return fc->passes ? (double)fc->combined / (double)fc->passes : 0.0;
+}
+
+#endif // FLAT_COMBINING_H
@@ -0,0 +1,144 @@
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Futex Syscall Wrappers
+// =============================================================================
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * Sleep while *addr == expected (FUTEX_WAIT)
+ *
+ * The kernel re-checks the value under its hash-bucket lock, so a wake that
+ * happens between our load and the syscall is never lost. Returns early on
+ * EAGAIN (value already changed), EINTR or spurious wakeups - always re-check
+ * the condition in a loop.
+ */
+static inline long futex_wait(atomic_int *addr, int expected) {
+    return syscall(SYS_futex, (int *)addr, FUTEX_WAIT_PRIVATE, expected,
+                   NULL, NULL, 0);
+}
+
+/**
+ * Wake up to nwake threads sleeping on addr (FUTEX_WAKE)
+ */
+static inline long futex_wake(atomic_int *addr, int nwake) {
+    return syscall(SYS_futex, (int *)addr, FUTEX_WAKE_PRIVATE, nwake,
+                   NULL, NULL, 0);
+}
+
+#else
+#include <sched.h>
+
+// No futex outside Linux: degrade to yielding. Callers already loop on the
+// condition, so a wake that does nothing is still correct - just slower.
+static inline long futex_wait(atomic_int *addr, int expected) {
+    (void)addr; (void)expected;
+    sched_yield();
+    return 0;
+}
+
+static inline long futex_wake(atomic_int *addr, int nwake) {
+    (void)addr; (void)nwake;
+    return 0;
+}
+#endif // __linux__
+
+// =============================================================================
+// Three-State Futex Mutex (Drepper, "Futexes Are Tricky", mutex #3)
+// =============================================================================
+
+/**
+ * State word:
+ *   0 = unlocked
+ *   1 = locked, no waiters
+ *   2 = locked, waiters may be sleeping (unlock must FUTEX_WAKE)
+ *
+ * Uncontended lock/unlock never enters the kernel. Contended lockers spin
+ * for a while first (adaptive, like glibc's PTHREAD_MUTEX_ADAPTIVE_NP) and
+ * only then park with FUTEX_WAIT.
+ */
+typedef struct {
+    atomic_int state;
+    atomic_int spin_estimate;   // Moving average of spins needed to acquire
+} futex_mutex_t;
+
+#define FUTEX_MUTEX_INITIALIZER { 0, 0 }
+
+#define FUTEX_SPIN_MIN 16
+#define FUTEX_SPIN_MAX 1000
+
+static inline void futex_mutex_init(futex_mutex_t *m) {
+    atomic_init(&m->state, 0);
+    atomic_init(&m->spin_estimate, 0);
+}
+
+static inline void futex_mutex_lock(futex_mutex_t *m) {
+    int c = 0;
+    // Fast path: 0 -> 1 with a single CAS (LOCK CMPXCHG), no syscall
+    if (atomic_compare_exchange_strong_explicit(
+            &m->state, &c, 1,
+            memory_order_acquire, memory_order_relaxed)) {
+        return;
+    }
+
+    // Spin phase: budget is twice the recent average of spins that won the
+    // lock. A spin that runs out decays the average by 1/8, so a lock that is
+    // always held long drifts back to FUTEX_SPIN_MIN and parks almost at once.
+    // Benign race on spin_estimate: it is only a hint.
+    int estimate = atomic_load_explicit(&m->spin_estimate, memory_order_relaxed);
+    int max_spins = estimate * 2 + FUTEX_SPIN_MIN;
+    if (max_spins > FUTEX_SPIN_MAX) max_spins = FUTEX_SPIN_MAX;
+
+    int spins = 0;
+    while (spins < max_spins) {
+        spins++;
+        CPU_PAUSE();
+        c = atomic_load_explicit(&m->state, memory_order_relaxed);
+        if (c == 0) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &m->state, &c, 1,
+                    memory_order_acquire, memory_order_relaxed)) {
+                atomic_store_explicit(&m->spin_estimate,
+                                      estimate + (spins - estimate) / 8,
+                                      memory_order_relaxed);
+                return;
+            }
+        }
+    }
+    atomic_store_explicit(&m->spin_estimate, estimate - (estimate + 7) / 8,
+                          memory_order_relaxed);
+
+    // Park phase: advertise a waiter by moving to 2. Whoever wakes us
+    // re-marks 2 on its own acquire, so no sleeper is ever forgotten.
+    if (c != 2) {
+        c = atomic_exchange_explicit(&m->state, 2, memory_order_acquire);
+    }
+    while (c != 0) {
+        futex_wait(&m->state, 2);
+        c = atomic_exchange_explicit(&m->state, 2, memory_order_acquire);
+    }
+}
+
+static inline int futex_mutex_trylock(futex_mutex_t *m) {
+    int c = 0;
+    return atomic_compare_exchange_strong_explicit(
+        &m->state, &c, 1, memory_order_acquire, memory_order_relaxed);
+}
+
+static inline void futex_mutex_unlock(futex_mutex_t *m) {
+    // Only pay for the syscall if someone announced they might be asleep
+    if (atomic_exchange_explicit(&m->state, 0, memory_order_release) == 2) {
+        futex_wake(&m->state, 1);
+    }
+}
+
+#endif // FUTEX_H
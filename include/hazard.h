@@ -0,0 +1,184 @@
+#ifndef HAZARD_H
+#define HAZARD_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Hazard Pointers (Michael, 2004) with Batched Scans
+// =============================================================================
+//
+// Epoch reclamation (ebr.h) protects a whole REGION: one reader descheduled
+// inside it stops reclamation for everybody. Hazard pointers protect single
+// OBJECTS: a reader publishes the exact pointer it is about to use, and only
+// that object is kept alive.
+//
+//   p = hp_protect(rec, 0, &shared)  load, publish in slot 0, re-validate
+//   ... use *p ...
+//   hp_clear(rec, 0)
+//   hp_retire(dom, rec, &old->node)  unlinked: free once no slot holds it
+//
+// Scanning every slot on every retire is O(threads). Instead retired nodes
+// collect in a private list until it reaches
+//     HP_SCAN_FACTOR * active threads * HP_PER_THREAD
+// and a scan snapshots all hazards once, sorts them, and binary-searches
+// each retired node: O(R log H) per batch, amortized O(log H) per retire.
+// Since at most H nodes can be protected, every scan frees at least R - H:
+// unreclaimed memory stays bounded no matter how long a reader stalls.
+//
+// The hp_node_t must be the FIRST member of the retired object: hazards
+// hold object addresses and scans compare them against node addresses.
+
+#define HP_MAX_THREADS 64
+#define HP_PER_THREAD 2
+#define HP_SCAN_FACTOR 2
+#define HP_MIN_THRESHOLD 32
+#define HP_SPINS_BEFORE_YIELD 256
+
+typedef struct hp_node {
+    struct hp_node *next;
+    void (*free_fn)(struct hp_node *node);
+} hp_node_t;
+
+typedef struct {
+    CACHE_ALIGNED _Atomic(void *) hp[HP_PER_THREAD];
+    // Private to the owning thread:
+    CACHE_ALIGNED hp_node_t *retired;
+    unsigned long nretired;
+    unsigned long retired_total, freed_total, scans;
+    int index;
+} hp_record_t;
+
+typedef struct {
+    _Atomic(hp_record_t *) records[HP_MAX_THREADS];
+    CACHE_ALIGNED atomic_int nthreads;
+} hp_domain_t;
+
+#define HP_DOMAIN_INITIALIZER { { 0 }, 0 }
+
+static inline void hp_register(hp_domain_t *d, hp_record_t *rec) {
+    memset(rec, 0, sizeof(*rec));
+    for (int i = 0; i < HP_MAX_THREADS; i++) {
+        hp_record_t *expected = NULL;
+        if (atomic_compare_exchange_strong(&d->records[i], &expected, rec)) {
+            rec->index = i;
+            atomic_fetch_add(&d->nthreads, 1);
+            return;
+        }
+    }
+    fprintf(stderr, "hazard: more than %d threads\n", HP_MAX_THREADS);
+    abort();
+}
+
+/**
+ * Load *src and protect it in slot i; the result is safe until hp_clear()
+ */
+static inline void *hp_protect(hp_record_t *rec, int i, _Atomic(void *) *src) {
+    void *p = atomic_load_explicit(src, memory_order_relaxed);
+    for (;;) {
+        atomic_store(&rec->hp[i], p);           // seq_cst: publish ...
+        void *again = atomic_load(src);         // ... then re-validate
+        if (again == p) {
+            return p;                           // Still linked: protected
+        }
+        p = again;
+    }
+}
+
+static inline void hp_clear(hp_record_t *rec, int i) {
+    atomic_store_explicit(&rec->hp[i], NULL, memory_order_release);
+}
+
+static inline int hp_ptr_cmp(const void *a, const void *b) {
+    uintptr_t x = *(const uintptr_t *)a, y = *(const uintptr_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Free every retired node no hazard pointer points to
+ */
+static inline void hp_scan(hp_domain_t *d, hp_record_t *rec) {
+    uintptr_t snap[HP_MAX_THREADS * HP_PER_THREAD];
+    size_t n = 0;
+
+    atomic_thread_fence(memory_order_seq_cst);  // Unlinks before the snapshot
+    for (int t = 0; t < HP_MAX_THREADS; t++) {
+        hp_record_t *r = atomic_load_explicit(&d->records[t], memory_order_acquire);
+        if (r == NULL) {
+            continue;
+        }
+        for (int i = 0; i < HP_PER_THREAD; i++) {
+            void *p = atomic_load_explicit(&r->hp[i], memory_order_acquire);
+            if (p) {
+                snap[n++] = (uintptr_t)p;
+            }
+        }
+    }
+    qsort(snap, n, sizeof(snap[0]), hp_ptr_cmp);
+
+    hp_node_t *keep = NULL, *node = rec->retired;
+    unsigned long kept = 0;
+    while (node) {
+        hp_node_t *next = node->next;
+        uintptr_t key = (uintptr_t)node;
+        if (n && bsearch(&key, snap, n, sizeof(snap[0]), hp_ptr_cmp)) {
+            node->next = keep;                  // Still hazardous
+            keep = node;
+            kept++;
+        } else {
+            node->free_fn(node);
+            rec->freed_total++;
+        }
+        node = next;
+    }
+    rec->retired = keep;
+    rec->nretired = kept;
+    rec->scans++;
+}
+
+static inline unsigned long hp_threshold(hp_domain_t *d) {
+    unsigned long r = (unsigned long)HP_SCAN_FACTOR * HP_PER_THREAD *
+                      atomic_load_explicit(&d->nthreads, memory_order_relaxed);
+    return r < HP_MIN_THRESHOLD ? HP_MIN_THRESHOLD : r;
+}
+
+/**
+ * Hand an unlinked node to the domain; freed by a later batched scan
+ */
+static inline void hp_retire(hp_domain_t *d, hp_record_t *rec, hp_node_t *node,
+                             void (*free_fn)(hp_node_t *node)) {
+    node->free_fn = free_fn;
+    node->next = rec->retired;
+    rec->retired = node;
+    rec->retired_total++;
+    if (++rec->nretired >= hp_threshold(d)) {
+        hp_scan(d, rec);
+    }
+}
+
+/**
+ * Clear this thread's hazards, free its retired nodes (waiting for other
+ * threads to drop theirs) and release the record
+ */
+static inline void hp_unregister(hp_domain_t *d, hp_record_t *rec) {
+    for (int i = 0; i < HP_PER_THREAD; i++) {
+        hp_clear(rec, i);
+    }
+    int spins = 0;
+    while (rec->nretired > 0) {
+        hp_scan(d, rec);
+        if (rec->nretired && ++spins >= HP_SPINS_BEFORE_YIELD) {
+            spins = 0;
+            sched_yield();
+        }
+    }
+    atomic_fetch_sub(&d->nthreads, 1);
+    atomic_store(&d->records[rec->index], NULL);
+}
+
+#endif // HAZARD_H
@@ -0,0 +1,205 @@
+#ifndef LFSTACK_H
+#define LFSTACK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Treiber Lock-Free Stack (tagged index) + Lock-Free Object Pool
+// =============================================================================
+//
+// push: node.next = top; CAS(top, old, node)
+// pop:  t = top; CAS(top, t, t.next)
+//
+// The ABA problem: thread A reads top = X (next = Y) and stalls; B pops X,
+// pops Y, pushes X back. A's CAS(top, X, Y) succeeds - and installs Y, which
+// is no longer on the stack. The CAS compared the pointer, not the HISTORY.
+//
+// Fix: top is a 64-bit word { tag:32 | index+1:32 }. Every successful CAS
+// bumps the tag, so a stale X never matches (until 2^32 wraps in one
+// stall). Nodes live in a fixed array and are never freed, so reading a
+// stale node's `next` is always safe memory - which also makes the stack a
+// perfect free list: see lf_pool_t below. One 64-bit CAS works on every
+// target; no cmpxchg16b needed.
+//
+// Elimination backoff (Hendler, Shavit, Yerushalmi): under heavy contention
+// a failed push parks its node in a random exchange slot for a moment; a
+// failed pop checks a random slot and takes a parked node. A matched
+// push/pop pair cancels out without touching `top` at all.
+
+#define LFS_EMPTY UINT32_MAX
+#define LFS_ELIM_SLOTS 8
+#define LFS_ELIM_SPINS 64           // How long a parked push waits for a pop
+
+typedef struct {
+    // tag << 32 | (index + 1), low half 0 = free. The tag changes on every
+    // park, so a pusher can't "withdraw" a later, different parking
+    CACHE_ALIGNED atomic_ullong value;
+} lfs_elim_slot_t;
+
+typedef struct {
+    CACHE_ALIGNED atomic_ullong top;    // tag << 32 | (index + 1); 0 = empty
+    atomic_uint *next;                  // next[i] = index + 1 below node i
+    uint32_t capacity;
+    bool elimination;
+    lfs_elim_slot_t elim[LFS_ELIM_SLOTS];
+} lf_stack_t;
+
+// Per-thread: operations completed through the elimination array
+static __thread unsigned long lfs_eliminated = 0;
+static __thread uint32_t lfs_seed = 0;
+
+static inline void lfs_init(lf_stack_t *s, uint32_t capacity, bool elimination) {
+    memset(s, 0, sizeof(*s));
+    s->next = calloc(capacity, sizeof(atomic_uint));
+    s->capacity = capacity;
+    s->elimination = elimination;
+}
+
+static inline void lfs_destroy(lf_stack_t *s) {
+    free(s->next);
+    s->next = NULL;
+}
+
+static inline uint64_t lfs_make(uint64_t old, uint32_t index_plus1) {
+    return ((old >> 32) + 1) << 32 | index_plus1;
+}
+
+static inline lfs_elim_slot_t *lfs_elim_pick(lf_stack_t *s) {
+    if (lfs_seed == 0) {
+        lfs_seed = (uint32_t)(uintptr_t)&lfs_seed | 1;
+    }
+    lfs_seed ^= lfs_seed << 13;
+    lfs_seed ^= lfs_seed >> 17;
+    lfs_seed ^= lfs_seed << 5;
+    return &s->elim[lfs_seed % LFS_ELIM_SLOTS];
+}
+
+/**
+ * Park node `index` for a waiting pop; true if a pop took it
+ */
+static inline bool lfs_elim_push(lf_stack_t *s, uint32_t index) {
+    lfs_elim_slot_t *slot = lfs_elim_pick(s);
+    uint64_t v = atomic_load_explicit(&slot->value, memory_order_relaxed);
+    if ((uint32_t)v != 0) {
+        return false;                   // Occupied
+    }
+    uint64_t parked = lfs_make(v, index + 1);
+    if (!atomic_compare_exchange_strong_explicit(&slot->value, &v, parked,
+                                                 memory_order_release,
+                                                 memory_order_relaxed)) {
+        return false;
+    }
+    for (int i = 0; i < LFS_ELIM_SPINS; i++) {
+        CPU_PAUSE();
+    }
+    if (atomic_compare_exchange_strong_explicit(&slot->value, &parked,
+                                                parked & ~(uint64_t)UINT32_MAX,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        return false;                   // Nobody came: take it back
+    }
+    lfs_eliminated++;
+    return true;                        // A pop took it
+}
+
+static inline uint32_t lfs_elim_pop(lf_stack_t *s) {
+    lfs_elim_slot_t *slot = lfs_elim_pick(s);
+    uint64_t v = atomic_load_explicit(&slot->value, memory_order_relaxed);
+    if ((uint32_t)v != 0 &&
+        atomic_compare_exchange_strong_explicit(&slot->value, &v,
+                                                v & ~(uint64_t)UINT32_MAX,
+                                                memory_order_acquire,
+                                                memory_order_relaxed)) {
+        lfs_eliminated++;
+        return (uint32_t)v - 1;
+    }
+    return LFS_EMPTY;
+}
+
+/**
+ * Push node `index` (0 <= index < capacity, not currently on the stack)
+ */
+static inline void lfs_push(lf_stack_t *s, uint32_t index) {
+    uint64_t old = atomic_load_explicit(&s->top, memory_order_relaxed);
+    for (;;) {
+        atomic_store_explicit(&s->next[index], (uint32_t)old, memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(&s->top, &old, lfs_make(old, index + 1),
+                                                  memory_order_release,
+                                                  memory_order_relaxed)) {
+            return;
+        }
+        if (s->elimination && lfs_elim_push(s, index)) {
+            return;
+        }
+    }
+}
+
+/**
+ * Pop a node index, or LFS_EMPTY
+ */
+static inline uint32_t lfs_pop(lf_stack_t *s) {
+    uint64_t old = atomic_load_explicit(&s->top, memory_order_acquire);
+    for (;;) {
+        uint32_t top = (uint32_t)old;
+        if (top == 0) {
+            return LFS_EMPTY;
+        }
+        // May be stale if we lose the race - harmless, the tag makes the CAS fail
+        uint32_t below = atomic_load_explicit(&s->next[top - 1], memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(&s->top, &old, lfs_make(old, below),
+                                                  memory_order_acquire,
+                                                  memory_order_acquire)) {
+            return top - 1;
+        }
+        if (s->elimination) {
+            uint32_t got = lfs_elim_pop(s);
+            if (got != LFS_EMPTY) {
+                return got;
+            }
+        }
+    }
+}
+
+// =============================================================================
+// Lock-free object pool: fixed-size objects, Treiber stack as the free list
+// =============================================================================
+
+typedef struct {
+    lf_stack_t free_list;
+    char *objects;
+    size_t object_size;             // Rounded up to a cache line
+} lf_pool_t;
+
+static inline void lf_pool_init(lf_pool_t *p, uint32_t count, size_t object_size,
+                                bool elimination) {
+    p->object_size = (object_size + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+    p->objects = cache_aligned_alloc(p->object_size * count);
+    lfs_init(&p->free_list, count, elimination);
+    for (uint32_t i = count; i-- > 0;) {
+        lfs_push(&p->free_list, i);
+    }
+}
+
+static inline void lf_pool_destroy(lf_pool_t *p) {
+    lfs_destroy(&p->free_list);
+    free(p->objects);
+}
+
+/**
+ * Take an object, or NULL if the pool is exhausted
+ */
+static inline void *lf_pool_alloc(lf_pool_t *p) {
+    uint32_t i = lfs_pop(&p->free_list);
+    return i == LFS_EMPTY ? NULL : p->objects + (size_t)i * p->object_size;
+}
+
+static inline void lf_pool_free(lf_pool_t *p, void *obj) {
+    lfs_push(&p->free_list, (uint32_t)(((char *)obj - p->objects) / p->object_size));
+}
+
+#endif // LFSTACK_H
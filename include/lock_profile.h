@@ -0,0 +1,232 @@
+#ifndef LOCK_PROFILE_H
+#define LOCK_PROFILE_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Lock Contention Profiler
+// =============================================================================
+//
+// Wraps ANY lock (TAS, TTAS, backoff, pthread spin/mutex, futex...) and splits
+// the time around it into:
+//
+//   wait     - lock() called → lock() returned
+//   hold     - lock() returned → unlock() called
+//   hand-off - previous unlock() → this lock() returned (contended only):
+//              how long the lock sat free before a waiter noticed
+//
+// Cost per timed acquisition: three RDTSC reads, two histogram increments in
+// the caller's own padded slot and one relaxed store to a shared "last
+// release" line. No locks, no shared counters. Define LOCKPROF_SAMPLE_SHIFT
+// (e.g. 4 = time 1 in 16) to cut that further; acquisition counts stay exact
+// and totals are scaled up in the report.
+//
+// Usage:
+//   static lockprof_t prof;                 // must outlive main()
+//   lockprof_init(&prof, "ttas");           // report printed at exit
+//
+//   LOCKPROF_CRITICAL(&prof, tid, ttas_lock(&l), ttas_unlock(&l)) {
+//       shared_counter++;                   // don't break/return in here
+//   }
+
+#define LOCKPROF_MAX_THREADS 64
+#define LOCKPROF_CONTENDED_NS 100   // Waits longer than this count as contended
+#ifndef LOCKPROF_SAMPLE_SHIFT
+#define LOCKPROF_SAMPLE_SHIFT 0     // Time 1 in 2^N acquisitions
+#endif
+#define LOCKPROF_SAMPLE_MASK ((1ULL << LOCKPROF_SAMPLE_SHIFT) - 1)
+
+typedef struct {
+    CACHE_ALIGNED uint64_t acquisitions;
+    uint64_t sampled;               // Acquisitions that were timed
+    uint64_t contended;             // ...of which waited > LOCKPROF_CONTENDED_NS
+    uint64_t wait_ticks;
+    uint64_t hold_ticks;
+    uint64_t handoff_ticks;
+    uint64_t hold_start;
+    hist_t wait;
+    hist_t hold;
+    hist_t handoff;
+} lockprof_slot_t;
+
+typedef struct lockprof {
+    const char *name;
+    double ticks_per_ns;
+    uint64_t contended_ticks;
+    struct lockprof *next;
+    CACHE_ALIGNED _Atomic uint64_t last_release;
+    lockprof_slot_t slots[LOCKPROF_MAX_THREADS];
+} lockprof_t;
+
+static _Atomic(lockprof_t *) lockprof_registry = NULL;
+static double lockprof_tsc_rate = 0.0;
+
+static inline void lockprof_report_all(void);
+
+/**
+ * Reset counters and register for the at-exit report
+ */
+static inline void lockprof_init(lockprof_t *p, const char *name) {
+    memset(p, 0, sizeof(*p));
+    if (lockprof_tsc_rate == 0.0) {
+        lockprof_tsc_rate = tsc_calibrate();
+    }
+    p->name = name;
+    p->ticks_per_ns = lockprof_tsc_rate;
+    p->contended_ticks = (uint64_t)(LOCKPROF_CONTENDED_NS * p->ticks_per_ns);
+
+    lockprof_t *head = atomic_load(&lockprof_registry);
+    if (head == NULL) {
+        atexit(lockprof_report_all);
+    }
+    do {
+        p->next = head;
+    } while (!atomic_compare_exchange_weak(&lockprof_registry, &head, p));
+}
+
+/**
+ * Start of an acquisition: timestamp, or 0 if this one is not sampled
+ */
+static inline uint64_t lockprof_begin(lockprof_t *p, int tid) {
+    lockprof_slot_t *s = &p->slots[tid % LOCKPROF_MAX_THREADS];
+    return (s->acquisitions & LOCKPROF_SAMPLE_MASK) == 0 ? get_ticks() : 0;
+}
+
+static inline void lockprof_acquired(lockprof_t *p, int tid, uint64_t t0) {
+    lockprof_slot_t *s = &p->slots[tid % LOCKPROF_MAX_THREADS];
+    s->acquisitions++;
+    if (t0 == 0) {
+        s->hold_start = 0;
+        return;
+    }
+
+    uint64_t now = get_ticks();
+    uint64_t wait = now - t0;
+    s->sampled++;
+    s->wait_ticks += wait;
+    hist_add(&s->wait, wait);
+    if (wait > p->contended_ticks) {
+        s->contended++;
+        // Only meaningful if the release happened while we were waiting
+        uint64_t released = atomic_load_explicit(&p->last_release, memory_order_relaxed);
+        if (released > t0 && released <= now) {
+            s->handoff_ticks += now - released;
+            hist_add(&s->handoff, now - released);
+        }
+    }
+    s->hold_start = now;
+}
+
+static inline void lockprof_release(lockprof_t *p, int tid) {
+    lockprof_slot_t *s = &p->slots[tid % LOCKPROF_MAX_THREADS];
+    if (s->hold_start == 0) return;
+
+    uint64_t now = get_ticks();
+    uint64_t hold = now - s->hold_start;
+
+    s->hold_ticks += hold;
+    hist_add(&s->hold, hold);
+    atomic_store_explicit(&p->last_release, now, memory_order_relaxed);
+}
+
+/**
+ * Wrap a critical section: LOCKPROF_CRITICAL(prof, tid, lock(), unlock()) { ... }
+ */
+#define LOCKPROF_CRITICAL(prof, tid, lock_expr, unlock_expr) \
+    for (uint64_t _lp_t0 = lockprof_begin((prof), (tid)), \
+                  _lp_i = ((lock_expr), lockprof_acquired((prof), (tid), _lp_t0), 0); \
+         _lp_i == 0; \
+         _lp_i++, lockprof_release((prof), (tid)), (unlock_expr))
+
+/**
+ * Print the contention report for one lock (merges per-thread slots)
+ */
+static inline void lockprof_report(lockprof_t *p) {
+    hist_t *wait = calloc(3, sizeof(hist_t));
+    hist_t *hold = wait + 1, *handoff = wait + 2;
+    uint64_t acq = 0, sampled = 0, contended = 0;
+    uint64_t wait_t = 0, hold_t = 0, handoff_t = 0;
+    double ns = 1.0 / p->ticks_per_ns;
+
+    for (int i = 0; i < LOCKPROF_MAX_THREADS; i++) {
+        lockprof_slot_t *s = &p->slots[i];
+        acq += s->acquisitions;
+        sampled += s->sampled;
+        contended += s->contended;
+        wait_t += s->wait_ticks;
+        hold_t += s->hold_ticks;
+        handoff_t += s->handoff_ticks;
+        hist_merge(wait, &s->wait);
+        hist_merge(hold, &s->hold);
+        hist_merge(handoff, &s->handoff);
+    }
+
+    printf("───────────────────────────────────────────────────────────\n");
+    printf("Lock profile: %s\n", p->name);
+    if (sampled == 0) {
+        printf("  (no acquisitions)\n");
+        free(wait);
+        return;
+    }
+    // Scale sampled totals up to all acquisitions
+    double scale = (double)acq / (double)sampled;
+    if (sampled != acq) {
+        printf("  (timing sampled: %lu of %lu acquisitions)\n",
+               (unsigned long)sampled, (unsigned long)acq);
+    }
+    printf("  Acquisitions: %lu  contended: %.0f (%.1f%%)  uncontended: %.0f\n",
+           (unsigned long)acq, contended * scale,
+           100.0 * contended / sampled, (sampled - contended) * scale);
+    printf("  Total time:   wait %.2f ms  hold %.2f ms  hand-off %.2f ms\n",
+           wait_t * scale * ns / 1e6, hold_t * scale * ns / 1e6,
+           handoff_t * scale * ns / 1e6);
+    printf("  %-9s %9s %9s %9s %9s %9s  (ns)\n",
+           "", "mean", "p50", "p90", "p99", "max");
+    const hist_t *hists[] = { wait, hold, handoff };
+    const char *names[] = { "wait", "hold", "hand-off" };
+    const uint64_t sums[] = { wait_t, hold_t, handoff_t };
+    for (int i = 0; i < 3; i++) {
+        const hist_t *h = hists[i];
+        printf("  %-9s %9.0f %9.0f %9.0f %9.0f %9.0f\n", names[i],
+               h->total ? sums[i] * ns / h->total : 0.0,
+               hist_percentile(h, 50) * ns, hist_percentile(h, 90) * ns,
+               hist_percentile(h, 99) * ns, h->max * ns);
+    }
+    printf("  Per-thread acquisition share:\n");
+    for (int i = 0; i < LOCKPROF_MAX_THREADS; i++) {
+        lockprof_slot_t *s = &p->slots[i];
+        if (s->sampled == 0) continue;
+        printf("    thread %2d: %9lu (%5.1f%%)  contended %5.1f%%  avg wait %8.0f ns\n",
+               i, (unsigned long)s->acquisitions,
+               100.0 * s->acquisitions / acq,
+               100.0 * s->contended / s->sampled,
+               s->wait_ticks * ns / s->sampled);
+    }
+    hist_print(wait, "  Wait-time histogram", ns, "ns");
+    hist_print(hold, "  Hold-time histogram", ns, "ns");
+    free(wait);
+}
+
+static inline void lockprof_report_all(void) {
+    printf("\n═══════════════════════════════════════════════════════════\n");
+    printf("  LOCK CONTENTION REPORT\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+    // Registry is LIFO; collect and print in registration order
+    int n = 0;
+    for (lockprof_t *p = atomic_load(&lockprof_registry); p; p = p->next) n++;
+    lockprof_t **order = malloc(sizeof(lockprof_t *) * (n > 0 ? n : 1));
+    int i = n;
+    for (lockprof_t *p = atomic_load(&lockprof_registry); p; p = p->next) {
+        order[--i] = p;
+    }
+    for (i = 0; i < n; i++) {
+        lockprof_report(order[i]);
+    }
+    free(order);
+}
+
+#endif // LOCK_PROFILE_H
@@ -0,0 +1,58 @@
+#ifndef LOCK_WORKLOAD_H
+#define LOCK_WORKLOAD_H
+
+#include <stdint.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Lock Benchmark Workload Knobs
+// =============================================================================
+//
+// A bare `shared_counter++` between lock() and unlock(), back to back, is the
+// 100%-contention corner case. Real code does some work under the lock and
+// some work outside it. Two knobs model that:
+//
+//   CS_LINES  - cache lines of shared data written inside the critical
+//               section (each one migrates to the new holder's cache)
+//   THINK_NS  - busy "non-critical" work between acquisitions
+//
+// Both default to 0 (the old behaviour). Override per build:
+//   make -B run-05 EXTRA_CFLAGS="-DCS_LINES=4 -DTHINK_NS=200"
+
+#ifndef CS_LINES
+#define CS_LINES 0
+#endif
+#ifndef THINK_NS
+#define THINK_NS 0
+#endif
+#define CS_MAX_LINES 256
+
+typedef struct {
+    CACHE_ALIGNED long words[CACHE_LINE_SIZE / sizeof(long)];
+} cs_line_t;
+
+// Shared data protected by whichever lock the benchmark is using
+static cs_line_t cs_data[CS_MAX_LINES];
+
+/**
+ * Critical-section work: read-modify-write one word in each of `lines` lines
+ */
+static inline void cs_work(int lines) {
+    for (int i = 0; i < lines && i < CS_MAX_LINES; i++) {
+        cs_data[i].words[0]++;
+    }
+    COMPILER_BARRIER();  // Keep the stores inside lock()/unlock()
+}
+
+/**
+ * Non-critical work: spin (without yielding the CPU) for ~ns nanoseconds
+ */
+static inline void think_ns(uint64_t ns) {
+    if (ns == 0) return;
+    uint64_t end = get_nanos() + ns;
+    while (get_nanos() < end) {
+        CPU_PAUSE();
+    }
+}
+
+#endif // LOCK_WORKLOAD_H
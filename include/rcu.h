@@ -0,0 +1,234 @@
+#ifndef RCU_H
+#define RCU_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Userspace RCU - Quiescent-State-Based Reclamation (QSBR)
+// =============================================================================
+//
+// Read-mostly data (configuration, routing tables) is read millions of times
+// per update. Even the best RW lock writes a shared line per read. RCU
+// readers write NOTHING shared inside a read section:
+//
+//   updater:  copy the object, modify the copy, rcu_assign_pointer(new)
+//             synchronize_rcu()   - wait until no reader can hold `old`
+//             free(old)           - or call_rcu(old) and let a thread do it
+//   reader:   rcu_read_lock()     - free: compiles to nothing
+//             p = rcu_dereference(ptr) ... use p ...
+//             rcu_read_unlock()   - free
+//             rcu_quiescent_state()  - every now and then, OUTSIDE read
+//                                      sections: "I hold no references"
+//
+// Grace periods: synchronize_rcu() bumps a global counter and waits until
+// every registered, online reader has announced a quiescent state (copied
+// the new counter into its own padded slot). Readers that block for a long
+// time go rcu_thread_offline() so they don't stall updaters.
+//
+// QSBR is the cheapest flavour (liburcu's urcu-qsbr) but it is intrusive:
+// every reader thread must register and must report quiescent states.
+
+#define RCU_MAX_READERS 128
+#define RCU_GP_ONLINE_STEP 2        // gp counter stays odd; 0 = offline
+#define RCU_SPINS_BEFORE_YIELD 256
+#define RCU_RECLAIM_INTERVAL_US 1000
+
+typedef struct {
+    CACHE_ALIGNED atomic_ulong ctr; // 0 = offline, else last gp observed
+} rcu_reader_t;
+
+typedef struct rcu_head {
+    struct rcu_head *next;
+    void (*func)(struct rcu_head *head);
+} rcu_head_t;
+
+static atomic_ulong rcu_gp_ctr = 1;
+static rcu_reader_t *rcu_readers[RCU_MAX_READERS];
+static pthread_mutex_t rcu_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread rcu_reader_t rcu_me;
+static __thread int rcu_my_index = -1;
+
+/**
+ * Publish / read an RCU-protected pointer (declare it _Atomic(T *))
+ */
+#define rcu_assign_pointer(p, v) atomic_store_explicit(&(p), (v), memory_order_release)
+#define rcu_dereference(p) atomic_load_explicit(&(p), memory_order_acquire)
+
+// Read-side critical sections cost nothing in QSBR
+#define rcu_read_lock() COMPILER_BARRIER()
+#define rcu_read_unlock() COMPILER_BARRIER()
+
+/**
+ * Announce: this thread holds no references from before this point
+ */
+static inline void rcu_quiescent_state(void) {
+    unsigned long gp = atomic_load_explicit(&rcu_gp_ctr, memory_order_acquire);
+    if (atomic_load_explicit(&rcu_me.ctr, memory_order_relaxed) != gp) {
+        atomic_store_explicit(&rcu_me.ctr, gp, memory_order_release);
+    }
+}
+
+/**
+ * Stop being waited for (about to block); no RCU pointers may be held
+ */
+static inline void rcu_thread_offline(void) {
+    atomic_store_explicit(&rcu_me.ctr, 0, memory_order_release);
+}
+
+static inline void rcu_thread_online(void) {
+    atomic_store(&rcu_me.ctr, atomic_load(&rcu_gp_ctr));
+    atomic_thread_fence(memory_order_seq_cst);  // Store ctr before any read
+}
+
+/**
+ * Every reader thread registers once before its first rcu_dereference()
+ */
+static inline void rcu_register_thread(void) {
+    pthread_mutex_lock(&rcu_registry_lock);
+    for (int i = 0; i < RCU_MAX_READERS; i++) {
+        if (rcu_readers[i] == NULL) {
+            rcu_readers[i] = &rcu_me;
+            rcu_my_index = i;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&rcu_registry_lock);
+    if (rcu_my_index < 0) {
+        fprintf(stderr, "rcu: more than %d reader threads\n", RCU_MAX_READERS);
+        abort();
+    }
+    rcu_thread_online();
+}
+
+static inline void rcu_unregister_thread(void) {
+    rcu_thread_offline();
+    pthread_mutex_lock(&rcu_registry_lock);
+    rcu_readers[rcu_my_index] = NULL;
+    rcu_my_index = -1;
+    pthread_mutex_unlock(&rcu_registry_lock);
+}
+
+/**
+ * Wait for a grace period: every reader online now has passed a quiescent
+ * state. Safe to call from a registered thread (it goes offline meanwhile).
+ */
+static inline void synchronize_rcu(void) {
+    bool was_online = rcu_my_index >= 0 &&
+                      atomic_load_explicit(&rcu_me.ctr, memory_order_relaxed) != 0;
+    if (was_online) {
+        rcu_thread_offline();
+    }
+
+    pthread_mutex_lock(&rcu_registry_lock);     // One grace period at a time
+    unsigned long gp = atomic_fetch_add(&rcu_gp_ctr, RCU_GP_ONLINE_STEP) +
+                       RCU_GP_ONLINE_STEP;      // seq_cst: after the publish
+    for (int i = 0; i < RCU_MAX_READERS; i++) {
+        rcu_reader_t *r = rcu_readers[i];
+        if (r == NULL) {
+            continue;
+        }
+        int spins = 0;
+        for (;;) {
+            unsigned long c = atomic_load(&r->ctr);
+            if (c == 0 || c == gp) {
+                break;                          // Offline, or saw the new gp
+            }
+            if (++spins < RCU_SPINS_BEFORE_YIELD) {
+                CPU_PAUSE();
+            } else {
+                sched_yield();                  // Reader may need our CPU
+            }
+        }
+    }
+    pthread_mutex_unlock(&rcu_registry_lock);
+
+    if (was_online) {
+        rcu_thread_online();
+    }
+}
+
+// =============================================================================
+// Deferred reclamation: call_rcu() + background reclaimer thread
+// =============================================================================
+//
+// synchronize_rcu() blocks the updater for a whole grace period. call_rcu()
+// queues a callback instead; the reclaimer thread collects the queue every
+// RCU_RECLAIM_INTERVAL_US, runs ONE grace period for the whole batch and
+// then invokes the callbacks (typically free()).
+
+typedef struct {
+    _Atomic(rcu_head_t *) pending;  // Lock-free push, reclaimer takes all
+    atomic_bool stop;
+    pthread_t thread;
+    atomic_ulong grace_periods;
+    atomic_ulong callbacks;
+} rcu_reclaimer_t;
+
+static rcu_reclaimer_t rcu_reclaimer;
+
+/**
+ * Run func(head) after a grace period; head is embedded in the old object
+ */
+static inline void call_rcu(rcu_head_t *head, void (*func)(rcu_head_t *head)) {
+    head->func = func;
+    rcu_head_t *old = atomic_load_explicit(&rcu_reclaimer.pending, memory_order_relaxed);
+    do {
+        head->next = old;
+    } while (!atomic_compare_exchange_weak_explicit(&rcu_reclaimer.pending, &old, head,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+/**
+ * Wait for a grace period and run everything queued so far; returns count
+ */
+static inline unsigned long rcu_reclaim_pending(void) {
+    rcu_head_t *list = atomic_exchange_explicit(&rcu_reclaimer.pending, NULL,
+                                                memory_order_acquire);
+    if (list == NULL) {
+        return 0;
+    }
+    synchronize_rcu();
+    atomic_fetch_add_explicit(&rcu_reclaimer.grace_periods, 1, memory_order_relaxed);
+    unsigned long n = 0;
+    while (list) {
+        rcu_head_t *next = list->next;
+        list->func(list);
+        list = next;
+        n++;
+    }
+    atomic_fetch_add_explicit(&rcu_reclaimer.callbacks, n, memory_order_relaxed);
+    return n;
+}
+
+static inline void *rcu_reclaimer_main(void *arg) {
+    (void)arg;
+    while (!atomic_load_explicit(&rcu_reclaimer.stop, memory_order_relaxed)) {
+        usleep(RCU_RECLAIM_INTERVAL_US);
+        rcu_reclaim_pending();
+    }
+    rcu_reclaim_pending();                      // Flush what's left
+    return NULL;
+}
+
+static inline void rcu_reclaimer_start(void) {
+    atomic_store(&rcu_reclaimer.stop, false);
+    pthread_create(&rcu_reclaimer.thread, NULL, rcu_reclaimer_main, NULL);
+}
+
+/**
+ * Stop the reclaimer after it has run every queued callback
+ */
+static inline void rcu_reclaimer_stop(void) {
+    atomic_store(&rcu_reclaimer.stop, true);
+    pthread_join(rcu_reclaimer.thread, NULL);
+}
+
+#endif // RCU_H
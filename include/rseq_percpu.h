@@ -0,0 +1,423 @@
+#ifndef RSEQ_PERCPU_H
+#define RSEQ_PERCPU_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "benchmark.h"
+
+#if defined(__has_include)
+#if __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>            // glibc >= 2.35 registers rseq for every thread
+#define RSEQ_GLIBC 1
+#endif
+#endif
+#ifndef RSEQ_GLIBC
+#include <linux/rseq.h>
+#endif
+
+// =============================================================================
+// Restartable Sequences (rseq) - Per-CPU Data Without Atomics
+// =============================================================================
+//
+// Per-thread shards (exercise 03, sharded_counter.h) cost one cache line per
+// THREAD: 500 threads on 64 CPUs = 500 lines to sum on every read. Per-CPU
+// shards cost one line per CPU, but a thread can be preempted or migrated
+// between sched_getcpu() and its update, so the update must still be a
+// lock-prefixed atomic.
+//
+// rseq (Linux 4.18+) removes that lock prefix. Each thread registers a
+// struct rseq; the kernel keeps cpu_id in it current, and if the thread is
+// preempted, migrated or signalled while its instruction pointer is inside a
+// registered critical section [start, start + post_commit_offset), the
+// kernel restarts it at abort_ip instead of resuming. So a section of the
+// form
+//     if (cpu_id != cpu) abort;     // still on the CPU we indexed with?
+//     ...loads...
+//     single store                  // commit: the last instruction
+// runs as if atomic with respect to every other thread on that CPU - using
+// plain loads and stores.
+//
+// Critical sections are hand-written asm (x86-64 only here):
+//   rseq_addv()                   *v += count                  (counters)
+//   rseq_cmpeqv_storev()          if (*v == expect) *v = newv  (list push)
+//   rseq_cmpnev_storeoffp_load()  pop: head = *v; *v = head->next
+// Every one returns 0 on commit and -1 when aborted (retry on the new CPU).
+//
+// Registration: glibc 2.35+ already registers an area for each thread (we
+// find it at the thread pointer + __rseq_offset); otherwise we register our
+// own with the rseq syscall. If neither works (old kernel, other arch,
+// GLIBC_TUNABLES=glibc.pthread.rseq=0, or built with -DNO_RSEQ) the
+// pc_counter_ and pc_list_ operations fall back to sched_getcpu() plus
+// atomics / a per-CPU spinlock. The choice is effectively process-wide:
+// both causes are properties of the kernel or the glibc tunable.
+
+#ifndef RSEQ_SIG
+#define RSEQ_SIG 0x53053053      // Must match the signature glibc registered
+#endif
+
+#if defined(__x86_64__) && !defined(NO_RSEQ)
+#define RSEQ_PERCPU_ASM 1
+#endif
+
+static __thread int rseq_state = 0;     // 0 = untried, 1 = registered, -1 = unavailable
+static __thread struct rseq *rseq_area = NULL;
+static __thread bool rseq_own_registered = false;
+static __thread struct rseq rseq_own_area __attribute__((aligned(32)));
+
+/**
+ * Find or create this thread's rseq area; false if rseq can't be used
+ */
+static inline bool rseq_register_current_thread(void) {
+    if (rseq_state != 0) {
+        return rseq_state > 0;
+    }
+    rseq_state = -1;
+#ifdef RSEQ_PERCPU_ASM
+#ifdef RSEQ_GLIBC
+    if (__rseq_size > 0) {
+        rseq_area = (struct rseq *)((char *)__builtin_thread_pointer() + __rseq_offset);
+        rseq_state = 1;
+        return true;
+    }
+#endif
+    memset(&rseq_own_area, 0, sizeof(rseq_own_area));
+    rseq_own_area.cpu_id = (uint32_t)RSEQ_CPU_ID_UNINITIALIZED;
+    if (syscall(__NR_rseq, &rseq_own_area, sizeof(rseq_own_area), 0, RSEQ_SIG) == 0) {
+        rseq_area = &rseq_own_area;
+        rseq_own_registered = true;
+        rseq_state = 1;
+    }
+#endif
+    return rseq_state > 0;
+}
+
+/**
+ * Undo our own registration before the thread exits (glibc's is left alone)
+ */
+static inline void rseq_unregister_current_thread(void) {
+    if (rseq_own_registered) {
+        syscall(__NR_rseq, &rseq_own_area, sizeof(rseq_own_area),
+                RSEQ_FLAG_UNREGISTER, RSEQ_SIG);
+        rseq_own_registered = false;
+    }
+    rseq_area = NULL;
+    rseq_state = 0;
+}
+
+static inline bool rseq_available(void) {
+    return rseq_register_current_thread();
+}
+
+/**
+ * CPU to index with before entering a critical section
+ */
+static inline int rseq_cpu_start(void) {
+    return (int)*(volatile uint32_t *)&rseq_area->cpu_id_start;
+}
+
+#ifdef RSEQ_PERCPU_ASM
+
+// Descriptor (struct rseq_cs) in its own section, then point rseq_cs at it.
+// The abort handler lives out of line and must be preceded by RSEQ_SIG - the
+// kernel checks it before jumping there.
+#define RSEQ_ASM_START                                                  \
+    ".pushsection __rseq_cs, \"aw\"\n\t"                                \
+    ".balign 32\n\t"                                                    \
+    "3:\n\t"                                                            \
+    ".long 0x0, 0x0\n\t"                                                \
+    ".quad 1f, (2f - 1f), 4f\n\t"                                       \
+    ".popsection\n\t"                                                   \
+    "leaq 3b(%%rip), %%rax\n\t"                                         \
+    "movq %%rax, %[rseq_cs]\n\t"                                        \
+    "1:\n\t"                                                            \
+    "cmpl %[cpu_id], %[current_cpu_id]\n\t"                             \
+    "jnz 4f\n\t"
+
+#define RSEQ_ASM_END(abort_label)                                       \
+    "2:\n\t"                                                            \
+    ".pushsection __rseq_failure, \"ax\"\n\t"                           \
+    ".byte 0x0f, 0xb9, 0x3d\n\t"                                        \
+    ".long 0x53053053\n\t"                                              \
+    "4:\n\t"                                                            \
+    "jmp %l[" #abort_label "]\n\t"                                      \
+    ".popsection\n\t"
+
+static inline int rseq_addv(long *v, long count, int cpu) {
+    __asm__ __volatile__ goto (
+        RSEQ_ASM_START
+        "addq %[count], %[v]\n\t"               // Commit
+        RSEQ_ASM_END(abort)
+        :
+        : [cpu_id] "r" (cpu),
+          [current_cpu_id] "m" (rseq_area->cpu_id),
+          [rseq_cs] "m" (rseq_area->rseq_cs),
+          [v] "m" (*v),
+          [count] "er" (count)
+        : "memory", "cc", "rax"
+        : abort);
+    return 0;
+abort:
+    return -1;
+}
+
+/**
+ * 0 = stored, 1 = *v != expect, -1 = aborted
+ */
+static inline int rseq_cmpeqv_storev(intptr_t *v, intptr_t expect, intptr_t newv, int cpu) {
+    __asm__ __volatile__ goto (
+        RSEQ_ASM_START
+        "cmpq %[v], %[expect]\n\t"
+        "jnz %l[cmpfail]\n\t"
+        "movq %[newv], %[v]\n\t"                // Commit
+        RSEQ_ASM_END(abort)
+        :
+        : [cpu_id] "r" (cpu),
+          [current_cpu_id] "m" (rseq_area->cpu_id),
+          [rseq_cs] "m" (rseq_area->rseq_cs),
+          [v] "m" (*v),
+          [expect] "r" (expect),
+          [newv] "r" (newv)
+        : "memory", "cc", "rax"
+        : abort, cmpfail);
+    return 0;
+abort:
+    return -1;
+cmpfail:
+    return 1;
+}
+
+/**
+ * if (*v != expectnot) { *load = *v; *v = *(*v + voffp); }
+ * 0 = popped, 1 = *v == expectnot, -1 = aborted. The head and its next are
+ * both read inside the section, so no ABA: nobody else on this CPU can run
+ * in between without aborting us.
+ */
+static inline int rseq_cmpnev_storeoffp_load(intptr_t *v, intptr_t expectnot, long voffp,
+                                             intptr_t *load, int cpu) {
+    __asm__ __volatile__ goto (
+        RSEQ_ASM_START
+        "movq %[v], %%rcx\n\t"
+        "cmpq %%rcx, %[expectnot]\n\t"
+        "je %l[cmpfail]\n\t"
+        "movq %%rcx, %[load]\n\t"
+        "addq %[voffp], %%rcx\n\t"
+        "movq (%%rcx), %%rcx\n\t"
+        "movq %%rcx, %[v]\n\t"                  // Commit
+        RSEQ_ASM_END(abort)
+        :
+        : [cpu_id] "r" (cpu),
+          [current_cpu_id] "m" (rseq_area->cpu_id),
+          [rseq_cs] "m" (rseq_area->rseq_cs),
+          [v] "m" (*v),
+          [expectnot] "r" (expectnot),
+          [voffp] "er" (voffp),
+          [load] "m" (*load)
+        : "memory", "cc", "rax", "rcx"
+        : abort, cmpfail);
+    return 0;
+abort:
+    return -1;
+cmpfail:
+    return 1;
+}
+
+#else // !RSEQ_PERCPU_ASM - never called: rseq_available() is false
+
+static inline int rseq_addv(long *v, long count, int cpu) {
+    (void)v; (void)count; (void)cpu;
+    return -1;
+}
+
+static inline int rseq_cmpeqv_storev(intptr_t *v, intptr_t expect, intptr_t newv, int cpu) {
+    (void)v; (void)expect; (void)newv; (void)cpu;
+    return -1;
+}
+
+static inline int rseq_cmpnev_storeoffp_load(intptr_t *v, intptr_t expectnot, long voffp,
+                                             intptr_t *load, int cpu) {
+    (void)v; (void)expectnot; (void)voffp; (void)load; (void)cpu;
+    return -1;
+}
+
+#endif // RSEQ_PERCPU_ASM
+
+static inline int pc_num_cpus(void) {
+    long n = sysconf(_SC_NPROCESSORS_CONF);
+    return n > 0 ? (int)n : 1;
+}
+
+/**
+ * Fallback slot: where we are now, which may be stale by the time we use it
+ */
+static inline int pc_fallback_cpu(int ncpus) {
+    int cpu = sched_getcpu();
+    return (cpu < 0 ? 0 : cpu) % ncpus;
+}
+
+// =============================================================================
+// Per-CPU counter
+// =============================================================================
+
+typedef struct {
+    CACHE_ALIGNED atomic_long value;
+} pc_slot_t;
+
+typedef struct {
+    pc_slot_t *slots;
+    int ncpus;
+} pc_counter_t;
+
+static inline void pc_counter_init(pc_counter_t *c) {
+    c->ncpus = pc_num_cpus();
+    c->slots = cache_aligned_alloc(sizeof(pc_slot_t) * c->ncpus);
+    for (int i = 0; i < c->ncpus; i++) {
+        atomic_init(&c->slots[i].value, 0);
+    }
+}
+
+static inline void pc_counter_destroy(pc_counter_t *c) {
+    free(c->slots);
+    c->slots = NULL;
+}
+
+static inline void pc_counter_add(pc_counter_t *c, long count) {
+    if (rseq_available()) {
+        for (;;) {
+            int cpu = rseq_cpu_start();
+            // Plain addq on x86 - other CPUs' relaxed loads see it whole
+            if (rseq_addv((long *)&c->slots[cpu].value, count, cpu) == 0) {
+                return;
+            }
+        }
+    }
+    atomic_fetch_add_explicit(&c->slots[pc_fallback_cpu(c->ncpus)].value, count,
+                              memory_order_relaxed);
+}
+
+/**
+ * Same slot choice as the fallback, but always atomic - the baseline rseq beats
+ */
+static inline void pc_counter_add_atomic(pc_counter_t *c, long count) {
+    atomic_fetch_add_explicit(&c->slots[pc_fallback_cpu(c->ncpus)].value, count,
+                              memory_order_relaxed);
+}
+
+static inline long pc_counter_read(pc_counter_t *c) {
+    long sum = 0;
+    for (int i = 0; i < c->ncpus; i++) {
+        sum += atomic_load_explicit(&c->slots[i].value, memory_order_relaxed);
+    }
+    return sum;
+}
+
+static inline void pc_counter_reset(pc_counter_t *c) {
+    for (int i = 0; i < c->ncpus; i++) {
+        atomic_store_explicit(&c->slots[i].value, 0, memory_order_relaxed);
+    }
+}
+
+// =============================================================================
+// Per-CPU free list: one intrusive LIFO per CPU
+// =============================================================================
+//
+// push/pop touch only the current CPU's list. A node may be pushed on a
+// different CPU than it was popped from, so lists drift; pc_list_pop()
+// returns NULL when THIS CPU's list is empty even if others are not.
+
+typedef struct pc_node {
+    struct pc_node *next;
+} pc_node_t;
+
+typedef struct {
+    CACHE_ALIGNED pc_node_t *head;
+    atomic_int lock;                // Fallback only
+} pc_head_t;
+
+typedef struct {
+    pc_head_t *heads;
+    int ncpus;
+} pc_list_t;
+
+static inline void pc_list_init(pc_list_t *l) {
+    l->ncpus = pc_num_cpus();
+    l->heads = cache_aligned_alloc(sizeof(pc_head_t) * l->ncpus);
+    memset(l->heads, 0, sizeof(pc_head_t) * l->ncpus);
+}
+
+static inline void pc_list_destroy(pc_list_t *l) {
+    free(l->heads);
+    l->heads = NULL;
+}
+
+static inline void pc_head_lock(pc_head_t *h) {
+    while (atomic_exchange_explicit(&h->lock, 1, memory_order_acquire)) {
+        while (atomic_load_explicit(&h->lock, memory_order_relaxed)) {
+            CPU_PAUSE();
+        }
+    }
+}
+
+static inline void pc_head_unlock(pc_head_t *h) {
+    atomic_store_explicit(&h->lock, 0, memory_order_release);
+}
+
+/**
+ * Push onto a specific CPU's list from any thread - setup only: the lock
+ * doesn't exclude concurrent rseq sections
+ */
+static inline void pc_list_push_cpu(pc_list_t *l, pc_node_t *node, int cpu) {
+    pc_head_t *h = &l->heads[cpu % l->ncpus];
+    pc_head_lock(h);
+    node->next = h->head;
+    h->head = node;
+    pc_head_unlock(h);
+}
+
+static inline void pc_list_push(pc_list_t *l, pc_node_t *node) {
+    if (rseq_available()) {
+        for (;;) {
+            int cpu = rseq_cpu_start();
+            pc_head_t *h = &l->heads[cpu];
+            intptr_t expect = (intptr_t)*(pc_node_t *volatile *)&h->head;
+            node->next = (pc_node_t *)expect;
+            if (rseq_cmpeqv_storev((intptr_t *)&h->head, expect, (intptr_t)node, cpu) == 0) {
+                return;
+            }
+        }
+    }
+    pc_list_push_cpu(l, node, pc_fallback_cpu(l->ncpus));
+}
+
+static inline pc_node_t *pc_list_pop(pc_list_t *l) {
+    if (rseq_available()) {
+        for (;;) {
+            int cpu = rseq_cpu_start();
+            intptr_t head;
+            int ret = rseq_cmpnev_storeoffp_load((intptr_t *)&l->heads[cpu].head, 0,
+                                                 offsetof(pc_node_t, next), &head, cpu);
+            if (ret == 0) {
+                return (pc_node_t *)head;
+            }
+            if (ret > 0) {
+                return NULL;
+            }
+        }
+    }
+    pc_head_t *h = &l->heads[pc_fallback_cpu(l->ncpus)];
+    pc_head_lock(h);
+    pc_node_t *node = h->head;
+    if (node) {
+        h->head = node->next;
+    }
+    pc_head_unlock(h);
+    return node;
+}
+
+#endif // RSEQ_PERCPU_H
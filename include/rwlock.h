@@ -0,0 +1,221 @@
+#ifndef RWLOCK_H
+#define RWLOCK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "benchmark.h"
+#include "futex.h"
+
+// =============================================================================
+// Reader-Writer Lock Policies (hand-rolled, futex blocking)
+// =============================================================================
+//
+// Exercise 02 uses pthread_rwlock_t, which on glibc prefers readers by
+// default: under steady read traffic a writer can wait forever. The policy
+// is the whole story, so here are three, all built the same way:
+//
+//   rp_*  reader-preferring  readers enter whenever no writer is ACTIVE
+//   wp_*  writer-preferring  readers also stay out while a writer WAITS
+//   pf_*  phase-fair         (Brandenburg & Anderson, PF-T) reader and
+//                            writer phases alternate: a writer waits for at
+//                            most one reader phase, a reader for at most
+//                            one writer
+//
+// Blocking: spin RW_SPIN_LIMIT times, then sleep on the lock's wait queue
+// (a futex sequence word). Releases bump the sequence and wake everyone, but
+// only if someone registered as a waiter - the uncontended path never
+// enters the kernel.
+
+#define RW_SPIN_LIMIT 128
+
+typedef struct {
+    atomic_int seq;                 // Futex word, bumped on every wake
+    atomic_int waiters;
+} rw_waitq_t;
+
+static inline int rw_wait_prepare(rw_waitq_t *q) {
+    atomic_fetch_add(&q->waiters, 1);       // seq_cst: pairs with rw_wake_all
+    return atomic_load(&q->seq);
+}
+
+static inline void rw_wait_done(rw_waitq_t *q) {
+    atomic_fetch_sub_explicit(&q->waiters, 1, memory_order_relaxed);
+}
+
+/**
+ * Call after publishing a state change; cheap when nobody sleeps
+ */
+static inline void rw_wake_all(rw_waitq_t *q) {
+    if (atomic_load(&q->waiters) > 0) {
+        atomic_fetch_add(&q->seq, 1);
+        futex_wake(&q->seq, INT_MAX);
+    }
+}
+
+/**
+ * Spin, then sleep, until `cond` is true. `cond` may have side effects (a
+ * successful trylock): it is evaluated until it returns true exactly once.
+ * Re-checking after rw_wait_prepare() closes the lost-wakeup window: either
+ * the waker sees our registration or we see its state change.
+ */
+#define RW_WAIT_UNTIL(q, cond)                                  \
+    do {                                                        \
+        int _rw_spins = 0;                                      \
+        while (!(cond)) {                                       \
+            if (++_rw_spins < RW_SPIN_LIMIT) {                  \
+                CPU_PAUSE();                                    \
+                continue;                                       \
+            }                                                   \
+            int _rw_seq = rw_wait_prepare(q);                   \
+            bool _rw_ok = (cond);                               \
+            if (!_rw_ok) futex_wait(&(q)->seq, _rw_seq);        \
+            rw_wait_done(q);                                    \
+            if (_rw_ok) break;                                  \
+        }                                                       \
+    } while (0)
+
+// =============================================================================
+// Reader-preferring: state = readers * 2 | writer_active
+// =============================================================================
+
+typedef struct {
+    atomic_uint state;
+    rw_waitq_t wq;
+} rp_rwlock_t;
+
+#define RP_RWLOCK_INITIALIZER { 0, { 0, 0 } }
+
+static inline bool rp_read_trylock(rp_rwlock_t *l) {
+    unsigned s = atomic_load_explicit(&l->state, memory_order_relaxed);
+    return !(s & 1u) && atomic_compare_exchange_weak(&l->state, &s, s + 2);
+}
+
+static inline void rp_read_lock(rp_rwlock_t *l) {
+    RW_WAIT_UNTIL(&l->wq, rp_read_trylock(l));
+}
+
+static inline void rp_read_unlock(rp_rwlock_t *l) {
+    if (atomic_fetch_sub(&l->state, 2) == 2) {
+        rw_wake_all(&l->wq);        // Last reader out: writers may go
+    }
+}
+
+static inline bool rp_write_trylock(rp_rwlock_t *l) {
+    unsigned s = 0;
+    return atomic_load_explicit(&l->state, memory_order_relaxed) == 0 &&
+           atomic_compare_exchange_weak(&l->state, &s, 1);
+}
+
+static inline void rp_write_lock(rp_rwlock_t *l) {
+    RW_WAIT_UNTIL(&l->wq, rp_write_trylock(l));
+}
+
+static inline void rp_write_unlock(rp_rwlock_t *l) {
+    atomic_fetch_sub(&l->state, 1);
+    rw_wake_all(&l->wq);
+}
+
+// =============================================================================
+// Writer-preferring: state = waiting_writers << 16 | readers * 2 | writer_active
+// =============================================================================
+
+#define WP_WRITER 1u
+#define WP_READER 2u
+#define WP_WAITING (1u << 16)
+#define WP_ACTIVE_MASK (WP_WAITING - 1)    // Active readers + active writer
+
+typedef struct {
+    atomic_uint state;
+    rw_waitq_t wq;
+} wp_rwlock_t;
+
+#define WP_RWLOCK_INITIALIZER { 0, { 0, 0 } }
+
+static inline bool wp_read_trylock(wp_rwlock_t *l) {
+    unsigned s = atomic_load_explicit(&l->state, memory_order_relaxed);
+    // Any writer active OR waiting keeps new readers out
+    return (s & (WP_WRITER | ~WP_ACTIVE_MASK)) == 0 &&
+           atomic_compare_exchange_weak(&l->state, &s, s + WP_READER);
+}
+
+static inline void wp_read_lock(wp_rwlock_t *l) {
+    RW_WAIT_UNTIL(&l->wq, wp_read_trylock(l));
+}
+
+static inline void wp_read_unlock(wp_rwlock_t *l) {
+    unsigned s = atomic_fetch_sub(&l->state, WP_READER) - WP_READER;
+    if ((s & WP_ACTIVE_MASK) == 0 && s != 0) {
+        rw_wake_all(&l->wq);        // Last reader out, writers waiting
+    }
+}
+
+// Called with our WP_WAITING already counted in state
+static inline bool wp_write_claim(wp_rwlock_t *l) {
+    unsigned s = atomic_load_explicit(&l->state, memory_order_relaxed);
+    return (s & WP_ACTIVE_MASK) == 0 &&
+           atomic_compare_exchange_weak(&l->state, &s, s - WP_WAITING + WP_WRITER);
+}
+
+static inline void wp_write_lock(wp_rwlock_t *l) {
+    atomic_fetch_add(&l->state, WP_WAITING);
+    RW_WAIT_UNTIL(&l->wq, wp_write_claim(l));
+}
+
+static inline void wp_write_unlock(wp_rwlock_t *l) {
+    atomic_fetch_sub(&l->state, WP_WRITER);
+    rw_wake_all(&l->wq);
+}
+
+// =============================================================================
+// Phase-fair (PF-T): reader entry/exit counters + writer ticket lock
+// =============================================================================
+//
+// rin's low two bits say "writer present" and which writer phase it is.
+// A reader that arrives during a writer phase waits only until those bits
+// CHANGE - i.e. for that one writer - not until all writers are gone.
+
+#define PF_RINC 0x100u              // Reader increment (above the flag bits)
+#define PF_WBITS 0x3u
+#define PF_PRES 0x2u                // Writer present
+#define PF_PHID 0x1u                // Writer phase id
+
+typedef struct {
+    atomic_uint rin, rout;          // Readers entered / exited (x PF_RINC)
+    atomic_uint win, wout;          // Writer tickets
+    rw_waitq_t wq;
+} pf_rwlock_t;
+
+#define PF_RWLOCK_INITIALIZER { 0, 0, 0, 0, { 0, 0 } }
+
+static inline void pf_read_lock(pf_rwlock_t *l) {
+    unsigned w = atomic_fetch_add(&l->rin, PF_RINC) & PF_WBITS;
+    if (w != 0) {
+        RW_WAIT_UNTIL(&l->wq, (atomic_load(&l->rin) & PF_WBITS) != w);
+    }
+}
+
+static inline void pf_read_unlock(pf_rwlock_t *l) {
+    atomic_fetch_add(&l->rout, PF_RINC);
+    if (atomic_load(&l->rin) & PF_PRES) {
+        rw_wake_all(&l->wq);        // A writer may be draining readers
+    }
+}
+
+static inline void pf_write_lock(pf_rwlock_t *l) {
+    unsigned ticket = atomic_fetch_add(&l->win, 1);
+    RW_WAIT_UNTIL(&l->wq, atomic_load(&l->wout) == ticket);
+
+    // Block new readers, then wait for the ones already inside
+    unsigned w = PF_PRES | (ticket & PF_PHID);
+    unsigned rticket = atomic_fetch_add(&l->rin, w);
+    RW_WAIT_UNTIL(&l->wq, atomic_load(&l->rout) == rticket);
+}
+
+static inline void pf_write_unlock(pf_rwlock_t *l) {
+    atomic_fetch_and(&l->rin, ~PF_WBITS);   // Release waiting readers
+    atomic_fetch_add(&l->wout, 1);          // ... then the next writer
+    rw_wake_all(&l->wq);
+}
+
+#endif // RWLOCK_H
@@ -0,0 +1,119 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Seqlock - Readers That Never Write Shared Memory
+// =============================================================================
+//
+// Even an uncontended rwlock read does an atomic RMW on the reader count:
+// every reader on every core pulls the same line into Modified state. A
+// seqlock reader only LOADS the sequence counter and retries if a writer
+// got in the way:
+//
+//   writer:  seq++ (odd)  ->  write record  ->  seq++ (even)
+//   reader:  s = seq (wait while odd)  ->  copy record  ->  retry if seq != s
+//
+// Ordering (Boehm, "Can Seqlocks Get Along With Programming Language Memory
+// Models?"), needed on ARM/POWER and by the C11 model everywhere:
+//   - record words are atomics accessed relaxed: a torn read is expected
+//     and thrown away, but must not be a data race (UB)
+//   - reader: acquire load of seq, relaxed copy, ACQUIRE FENCE, relaxed
+//     re-load of seq - the fence keeps the copy before the re-check
+//   - writer: relaxed odd store, RELEASE FENCE, relaxed copy, release even
+//     store - the fence keeps the copy after the odd store
+//
+// Writers serialize on a TTAS word inside the seqlock. Records may span
+// many cache lines; readers copy them out and use the copy.
+
+typedef struct {
+    CACHE_ALIGNED atomic_uint seq;  // Odd = write in progress
+    atomic_bool writer;             // Serializes writers
+} seqlock_t;
+
+#define SEQLOCK_INITIALIZER { 0, false }
+
+/**
+ * Start a read: returns the (even) sequence to validate against
+ */
+static inline unsigned seqlock_read_begin(seqlock_t *sl) {
+    unsigned s;
+    while ((s = atomic_load_explicit(&sl->seq, memory_order_acquire)) & 1u) {
+        CPU_PAUSE();
+    }
+    return s;
+}
+
+/**
+ * End a read: true if a writer interfered and the copy must be discarded
+ */
+static inline bool seqlock_read_retry(seqlock_t *sl, unsigned start) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&sl->seq, memory_order_relaxed) != start;
+}
+
+static inline void seqlock_write_lock(seqlock_t *sl) {
+    for (;;) {
+        while (atomic_load_explicit(&sl->writer, memory_order_relaxed)) {
+            CPU_PAUSE();
+        }
+        if (!atomic_exchange_explicit(&sl->writer, true, memory_order_acquire)) {
+            break;
+        }
+    }
+    unsigned s = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void seqlock_write_unlock(seqlock_t *sl) {
+    unsigned s = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, s + 1, memory_order_release);
+    atomic_store_explicit(&sl->writer, false, memory_order_release);
+}
+
+// Record word copies - relaxed atomics, the seqlock provides the ordering
+
+static inline void seqlock_load_words(unsigned long *dst, const atomic_ulong *src, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = atomic_load_explicit(&src[i], memory_order_relaxed);
+    }
+}
+
+static inline void seqlock_store_words(atomic_ulong *dst, const unsigned long *src, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        atomic_store_explicit(&dst[i], src[i], memory_order_relaxed);
+    }
+}
+
+/**
+ * Copy a consistent snapshot of an n-word record; returns retries needed
+ */
+static inline unsigned seqlock_read_copy(seqlock_t *sl, const atomic_ulong *src,
+                                         unsigned long *dst, size_t n) {
+    unsigned retries = 0;
+    for (;;) {
+        unsigned s = seqlock_read_begin(sl);
+        seqlock_load_words(dst, src, n);
+        if (!seqlock_read_retry(sl, s)) {
+            return retries;
+        }
+        retries++;
+    }
+}
+
+/**
+ * Replace an n-word record under the seqlock
+ */
+static inline void seqlock_write_copy(seqlock_t *sl, atomic_ulong *dst,
+                                      const unsigned long *src, size_t n) {
+    seqlock_write_lock(sl);
+    seqlock_store_words(dst, src, n);
+    seqlock_write_unlock(sl);
+}
+
+#endif // SEQLOCK_H
@@ -0,0 +1,119 @@
+#ifndef SHARDED_COUNTER_H
+#define SHARDED_COUNTER_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sched.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Sharded Counter - Scalable Adds, Summed Reads
+// =============================================================================
+//
+// Exercise 01: every thread fetch_add()s one atomic_long, so the line
+// ping-pongs between cores and adds serialize. Exercise 03: padded
+// per-thread counters fix that, but you sum them by hand.
+//
+// A sharded counter packages the fix:
+//   sc_add()          fetch_add on THIS thread's padded shard (local line)
+//   sc_read()         sum of all shards - exact at some instant only if
+//                     nobody is adding; O(shards) cache misses
+//   sc_read_approx()  cached total, re-summed at most every refresh_ns by
+//                     whichever reader finds it stale - O(1) for readers:
+//                     staleness is checked with get_ticks() (RDTSC), not a
+//                     clock_gettime() per read
+//   sc_reset()        zero every shard (adds racing with it may survive)
+//
+// Shards are per thread (round-robin on first use, wraps past
+// SC_MAX_SHARDS). Build with -DSC_PER_CPU to index by sched_getcpu():
+// fewer shards than threads, but two threads can share one after a
+// migration - that's why adds stay atomic.
+
+#define SC_MAX_SHARDS 64
+
+typedef struct {
+    CACHE_ALIGNED atomic_long value;
+} sc_shard_t;
+
+typedef struct {
+    sc_shard_t shards[SC_MAX_SHARDS];
+    CACHE_ALIGNED atomic_long cached_total;
+    atomic_ullong cached_at;        // get_ticks() of the last refresh
+    uint64_t refresh_ticks;
+} sharded_counter_t;
+
+static double sc_ticks_per_ns = 0;  // tsc_calibrate(), once per process
+
+#ifndef SC_PER_CPU
+static atomic_int sc_next_shard = 0;
+static __thread int sc_thread_shard = -1;
+#endif
+
+static inline int sc_shard(void) {
+#ifdef SC_PER_CPU
+    int cpu = sched_getcpu();
+    return (cpu < 0 ? 0 : cpu) % SC_MAX_SHARDS;
+#else
+    if (sc_thread_shard < 0) {
+        sc_thread_shard = atomic_fetch_add(&sc_next_shard, 1) % SC_MAX_SHARDS;
+    }
+    return sc_thread_shard;
+#endif
+}
+
+/**
+ * refresh_ns: maximum age of the total returned by sc_read_approx().
+ * The first non-zero refresh_ns calibrates the TSC (~10ms)
+ */
+static inline void sc_init(sharded_counter_t *c, uint64_t refresh_ns) {
+    for (int i = 0; i < SC_MAX_SHARDS; i++) {
+        atomic_init(&c->shards[i].value, 0);
+    }
+    atomic_init(&c->cached_total, 0);
+    atomic_init(&c->cached_at, 0);
+    if (refresh_ns && sc_ticks_per_ns == 0) {
+        sc_ticks_per_ns = tsc_calibrate();
+    }
+    c->refresh_ticks = (uint64_t)((double)refresh_ns * sc_ticks_per_ns);
+}
+
+static inline void sc_add(sharded_counter_t *c, long delta) {
+    atomic_fetch_add_explicit(&c->shards[sc_shard()].value, delta, memory_order_relaxed);
+}
+
+static inline void sc_inc(sharded_counter_t *c) {
+    sc_add(c, 1);
+}
+
+static inline long sc_read(sharded_counter_t *c) {
+    long sum = 0;
+    for (int i = 0; i < SC_MAX_SHARDS; i++) {
+        sum += atomic_load_explicit(&c->shards[i].value, memory_order_relaxed);
+    }
+    return sum;
+}
+
+/**
+ * Total at most refresh_ns old; only one reader at a time pays for the sum
+ */
+static inline long sc_read_approx(sharded_counter_t *c) {
+    uint64_t now = get_ticks();
+    unsigned long long at = atomic_load_explicit(&c->cached_at, memory_order_acquire);
+    if (now - at >= c->refresh_ticks &&
+        atomic_compare_exchange_strong_explicit(&c->cached_at, &at, now,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        atomic_store_explicit(&c->cached_total, sc_read(c), memory_order_relaxed);
+    }
+    return atomic_load_explicit(&c->cached_total, memory_order_relaxed);
+}
+
+static inline void sc_reset(sharded_counter_t *c) {
+    for (int i = 0; i < SC_MAX_SHARDS; i++) {
+        atomic_store_explicit(&c->shards[i].value, 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&c->cached_total, 0, memory_order_relaxed);
+    atomic_store_explicit(&c->cached_at, 0, memory_order_release);
+}
+
+#endif // SHARDED_COUNTER_H
@@ -0,0 +1,224 @@
+#ifndef SNZI_H
+#define SNZI_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sched.h>
+#include "benchmark.h"
+
+// =============================================================================
+// SNZI - Scalable Non-Zero Indicator (Ellen, Lev, Luchangco, Moir, PODC'07)
+// =============================================================================
+//
+// A counter that only answers "is it non-zero?". That weaker question lets
+// arrivals and departures stay in the leaves of a tree:
+//
+//                       root          <- changes only on 0 <-> non-zero
+//                     /      \        <- one cache line per node
+//                  node      node     <- changes only when a child does
+//                 /   \     /   \     <- node i's parent is (i-1)/2
+//               leaf leaf leaf leaf   <- threads arrive/depart here
+//
+// A node tells its parent about its own 0 -> 1 and 1 -> 0 transitions and
+// nothing else. While a leaf's count stays above zero (several threads on
+// it, or a thread holding two references), arrive/depart touch only that
+// leaf's line, and the root line that snzi_query() reads stays shared.
+//
+// The 0 -> 1 race: a node first moves to 1/2, arrives at its parent, then
+// CASes 1/2 -> 1. Concurrent arrivers that see 1/2 help by arriving at the
+// parent too, and undo their extra parent arrival if their CAS loses. The
+// version in the word changes on every 0 -> 1/2, so a stale 1/2 can't be
+// mistaken for a new one (ABA).
+//
+// Every node is one word: version << 32 | count * 2 (+1 for the 1/2 state).
+// The root is a plain counter. snzi_arrive() returns the leaf it used;
+// snzi_depart() must get the same leaf back - like br_read_lock().
+//
+// Leaves are per thread (round-robin on first use, wrapping past
+// SNZI_LEAVES) or, with -DSNZI_PER_CPU, picked by sched_getcpu().
+//
+// The same arrive/depart/query is the reader indicator a writer-preferring
+// RW lock needs: readers arrive/depart, a writer waits for !snzi_query().
+
+#define SNZI_LEAVES 16                          // Power of two
+#define SNZI_NODES (2 * SNZI_LEAVES - 1)        // Heap order: node i's parent is (i-1)/2
+
+#define SNZI_HALF 1ULL
+#define SNZI_ONE 2ULL
+
+typedef struct {
+    CACHE_ALIGNED atomic_ullong word;
+} snzi_node_t;
+
+typedef struct {
+    snzi_node_t nodes[SNZI_NODES];              // nodes[0] is the root
+} snzi_t;
+
+#ifndef SNZI_PER_CPU
+static atomic_int snzi_next_leaf = 0;
+static __thread int snzi_thread_leaf = -1;
+#endif
+
+static inline void snzi_init(snzi_t *s) {
+    for (int i = 0; i < SNZI_NODES; i++) {
+        atomic_init(&s->nodes[i].word, 0);
+    }
+}
+
+static inline int snzi_leaf(void) {
+#ifdef SNZI_PER_CPU
+    int cpu = sched_getcpu();
+    return (cpu < 0 ? 0 : cpu) % SNZI_LEAVES;
+#else
+    if (snzi_thread_leaf < 0) {
+        snzi_thread_leaf = atomic_fetch_add(&snzi_next_leaf, 1) % SNZI_LEAVES;
+    }
+    return snzi_thread_leaf;
+#endif
+}
+
+static inline uint64_t snzi_make(uint64_t version, uint64_t count2) {
+    return version << 32 | count2;
+}
+
+static inline void snzi_arrive_node(snzi_t *s, int i);
+
+/**
+ * Returns true if this departure took the whole SNZI to zero
+ */
+static inline bool snzi_depart_node(snzi_t *s, int i) {
+    atomic_ullong *w = &s->nodes[i].word;
+    if (i == 0) {
+        return atomic_fetch_sub(w, 1) == 1;
+    }
+    uint64_t x = atomic_load_explicit(w, memory_order_relaxed);
+    for (;;) {
+        // A departing thread's arrival completed, so the count is whole (>= 1)
+        if (atomic_compare_exchange_weak(w, &x, x - SNZI_ONE)) {
+            if ((uint32_t)x == SNZI_ONE) {
+                return snzi_depart_node(s, (i - 1) / 2);
+            }
+            return false;
+        }
+    }
+}
+
+static inline void snzi_arrive_node(snzi_t *s, int i) {
+    atomic_ullong *w = &s->nodes[i].word;
+    if (i == 0) {
+        atomic_fetch_add(w, 1);
+        return;
+    }
+    int parent = (i - 1) / 2;
+    int undo = 0;
+    bool done = false;
+    while (!done) {
+        uint64_t x = atomic_load(w);
+        uint64_t c = (uint32_t)x, v = x >> 32;
+        if (c >= SNZI_ONE) {
+            if (atomic_compare_exchange_strong(w, &x, x + SNZI_ONE)) {
+                done = true;
+            }
+            continue;
+        }
+        if (c == 0) {
+            uint64_t half = snzi_make(v + 1, SNZI_HALF);
+            if (!atomic_compare_exchange_strong(w, &x, half)) {
+                continue;
+            }
+            done = true;
+            x = half;
+        }
+        // x is 1/2 (ours or someone else's): make the parent non-zero, then 1
+        snzi_arrive_node(s, parent);
+        if (!atomic_compare_exchange_strong(w, &x, snzi_make(x >> 32, SNZI_ONE))) {
+            undo++;
+        }
+    }
+    while (undo-- > 0) {
+        snzi_depart_node(s, parent);
+    }
+}
+
+/**
+ * Returns the leaf to hand back to snzi_depart()
+ */
+static inline int snzi_arrive(snzi_t *s) {
+    int leaf = SNZI_LEAVES - 1 + snzi_leaf();
+    snzi_arrive_node(s, leaf);
+    return leaf;
+}
+
+/**
+ * Returns true if the SNZI is now zero (this was the last departure)
+ */
+static inline bool snzi_depart(snzi_t *s, int leaf) {
+    return snzi_depart_node(s, leaf);
+}
+
+/**
+ * Is anybody present? One load of a line that rarely changes
+ */
+static inline bool snzi_query(snzi_t *s) {
+    return atomic_load(&s->nodes[0].word) != 0;
+}
+
+// =============================================================================
+// Split reference count: a few owner references + SNZI for transient readers
+// =============================================================================
+//
+// Owners (the table that holds the object, the creator) keep a plain count
+// that rarely changes. Readers arrive/depart on the SNZI. The object is
+// dead when both are zero. The last owner put and the last reader put check
+// each other's side with seq_cst operations, so at least one of them sees
+// both at zero; `released` makes sure exactly one returns true.
+//
+// As with any refcount, a reader may only sref_get() while it can reach the
+// object through an owner reference (or already holds one).
+
+typedef struct {
+    snzi_t readers;
+    CACHE_ALIGNED atomic_long owners;
+    atomic_int released;
+} split_ref_t;
+
+static inline void sref_init(split_ref_t *r, long owners) {
+    snzi_init(&r->readers);
+    atomic_init(&r->owners, owners);
+    atomic_init(&r->released, 0);
+}
+
+static inline bool sref_release_once(split_ref_t *r) {
+    return atomic_exchange(&r->released, 1) == 0;
+}
+
+/**
+ * Returns the leaf to hand back to sref_put()
+ */
+static inline int sref_get(split_ref_t *r) {
+    return snzi_arrive(&r->readers);
+}
+
+/**
+ * Returns true if the caller dropped the last reference and must free
+ */
+static inline bool sref_put(split_ref_t *r, int leaf) {
+    if (snzi_depart(&r->readers, leaf) && atomic_load(&r->owners) == 0) {
+        return sref_release_once(r);
+    }
+    return false;
+}
+
+static inline void sref_get_owner(split_ref_t *r) {
+    atomic_fetch_add(&r->owners, 1);
+}
+
+static inline bool sref_put_owner(split_ref_t *r) {
+    if (atomic_fetch_sub(&r->owners, 1) == 1 && !snzi_query(&r->readers)) {
+        return sref_release_once(r);
+    }
+    return false;
+}
+
+#endif // SNZI_H
@@ -0,0 +1,364 @@
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "benchmark.h"
+
+// =============================================================================
+// Spinlock Family (reusable versions of exercise 05)
+// =============================================================================
+//
+// Same algorithms as exercises/05_spinlock_internals, packaged as static
+// inline functions so the later lock benchmarks can share one copy, plus two
+// queue locks (ticket, MCS) that hand the lock off in FIFO order and an
+// abortable queue lock for deadline-bound callers.
+//
+// *_trylock() never waits; *_lock_timeout(ns) gives up after ~ns and returns
+// false WITHOUT holding the lock.
+
+#define TAS_SPINLOCK_INITIALIZER  { ATOMIC_FLAG_INIT }
+#define TTAS_SPINLOCK_INITIALIZER { false }
+#define BACKOFF_SPINLOCK_INITIALIZER { false }
+
+/**
+ * TAS: every spin is an atomic exchange (LOCK XCHG)
+ */
+typedef struct {
+    atomic_flag lock;
+} tas_spinlock_t;
+
+static inline void tas_lock(tas_spinlock_t *lock) {
+    while (atomic_flag_test_and_set_explicit(&lock->lock, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+}
+
+static inline void tas_unlock(tas_spinlock_t *lock) {
+    atomic_flag_clear_explicit(&lock->lock, memory_order_release);
+}
+
+static inline bool tas_trylock(tas_spinlock_t *lock) {
+    return !atomic_flag_test_and_set_explicit(&lock->lock, memory_order_acquire);
+}
+
+/**
+ * Spin at most ~ns nanoseconds; false = deadline passed, lock NOT held
+ */
+static inline bool tas_lock_timeout(tas_spinlock_t *lock, uint64_t ns) {
+    uint64_t deadline = get_nanos() + ns;
+    while (atomic_flag_test_and_set_explicit(&lock->lock, memory_order_acquire)) {
+        if (get_nanos() >= deadline) return false;
+        CPU_PAUSE();
+    }
+    return true;
+}
+
+/**
+ * TTAS: spin on a plain load (cache-local), CAS only when it looks free
+ */
+typedef struct {
+    atomic_bool locked;
+} ttas_spinlock_t;
+
+static inline void ttas_lock(ttas_spinlock_t *lock) {
+    while (1) {
+        if (!atomic_load_explicit(&lock->locked, memory_order_relaxed)) {
+            bool expected = false;
+            if (atomic_compare_exchange_weak_explicit(
+                    &lock->locked, &expected, true,
+                    memory_order_acquire, memory_order_relaxed)) {
+                return;
+            }
+        }
+        CPU_PAUSE();
+    }
+}
+
+static inline void ttas_unlock(ttas_spinlock_t *lock) {
+    atomic_store_explicit(&lock->locked, false, memory_order_release);
+}
+
+static inline bool ttas_trylock(ttas_spinlock_t *lock) {
+    bool expected = false;
+    return !atomic_load_explicit(&lock->locked, memory_order_relaxed) &&
+           atomic_compare_exchange_strong_explicit(
+               &lock->locked, &expected, true,
+               memory_order_acquire, memory_order_relaxed);
+}
+
+static inline bool ttas_lock_timeout(ttas_spinlock_t *lock, uint64_t ns) {
+    uint64_t deadline = get_nanos() + ns;
+    while (!ttas_trylock(lock)) {
+        if (get_nanos() >= deadline) return false;
+        CPU_PAUSE();
+    }
+    return true;
+}
+
+/**
+ * TTAS + exponential backoff (4 -> 8 -> ... -> 1024 pauses)
+ */
+typedef struct {
+    atomic_bool locked;
+} backoff_spinlock_t;
+
+#ifndef BACKOFF_MIN
+#define BACKOFF_MIN 4
+#endif
+#ifndef BACKOFF_MAX
+#define BACKOFF_MAX 1024
+#endif
+
+static inline void backoff_lock(backoff_spinlock_t *lock) {
+    int backoff = BACKOFF_MIN;
+    while (1) {
+        if (!atomic_load_explicit(&lock->locked, memory_order_relaxed)) {
+            bool expected = false;
+            if (atomic_compare_exchange_weak_explicit(
+                    &lock->locked, &expected, true,
+                    memory_order_acquire, memory_order_relaxed)) {
+                return;
+            }
+        }
+        for (int i = 0; i < backoff; i++) {
+            CPU_PAUSE();
+        }
+        backoff = (backoff * 2 > BACKOFF_MAX) ? BACKOFF_MAX : backoff * 2;
+    }
+}
+
+static inline void backoff_unlock(backoff_spinlock_t *lock) {
+    atomic_store_explicit(&lock->locked, false, memory_order_release);
+}
+
+static inline bool backoff_trylock(backoff_spinlock_t *lock) {
+    bool expected = false;
+    return !atomic_load_explicit(&lock->locked, memory_order_relaxed) &&
+           atomic_compare_exchange_strong_explicit(
+               &lock->locked, &expected, true,
+               memory_order_acquire, memory_order_relaxed);
+}
+
+/**
+ * Backoff never sleeps past the deadline: the last pause burst is trimmed
+ */
+static inline bool backoff_lock_timeout(backoff_spinlock_t *lock, uint64_t ns) {
+    uint64_t deadline = get_nanos() + ns;
+    int backoff = BACKOFF_MIN;
+    while (!backoff_trylock(lock)) {
+        for (int i = 0; i < backoff; i++) {
+            CPU_PAUSE();
+            if ((i & 63) == 63 && get_nanos() >= deadline) return false;
+        }
+        if (get_nanos() >= deadline) return false;
+        backoff = (backoff * 2 > BACKOFF_MAX) ? BACKOFF_MAX : backoff * 2;
+    }
+    return true;
+}
+
+/**
+ * Ticket lock: FIFO hand-off, one fetch_add to take a ticket
+ *
+ * Fair, but every waiter spins on the same now_serving line, so each
+ * release still invalidates all of them.
+ */
+typedef struct {
+    atomic_uint next_ticket;
+    atomic_uint now_serving;
+} ticket_spinlock_t;
+
+#define TICKET_SPINLOCK_INITIALIZER { 0, 0 }
+
+static inline void ticket_lock(ticket_spinlock_t *lock) {
+    unsigned me = atomic_fetch_add_explicit(&lock->next_ticket, 1, memory_order_relaxed);
+    while (atomic_load_explicit(&lock->now_serving, memory_order_acquire) != me) {
+        CPU_PAUSE();
+    }
+}
+
+static inline void ticket_unlock(ticket_spinlock_t *lock) {
+    // Only the holder writes now_serving: plain load + store is enough
+    unsigned next = atomic_load_explicit(&lock->now_serving, memory_order_relaxed) + 1;
+    atomic_store_explicit(&lock->now_serving, next, memory_order_release);
+}
+
+/**
+ * MCS queue lock: each waiter spins on its OWN node (one cache line)
+ *
+ * A release touches exactly one waiter's line instead of all of them, so
+ * hand-off cost stays flat as thread count grows. The caller supplies the
+ * node and passes the same one to unlock; keep it per thread (stack is fine).
+ */
+typedef struct mcs_node {
+    CACHE_ALIGNED _Atomic(struct mcs_node *) next;
+    atomic_bool locked;
+} mcs_node_t;
+
+typedef struct {
+    _Atomic(mcs_node_t *) tail;
+} mcs_lock_t;
+
+#define MCS_LOCK_INITIALIZER { NULL }
+
+static inline void mcs_lock(mcs_lock_t *lock, mcs_node_t *me) {
+    atomic_store_explicit(&me->next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&me->locked, true, memory_order_relaxed);
+
+    mcs_node_t *prev = atomic_exchange_explicit(&lock->tail, me, memory_order_acq_rel);
+    if (prev == NULL) {
+        return;  // Queue was empty: lock is ours
+    }
+    atomic_store_explicit(&prev->next, me, memory_order_release);
+    while (atomic_load_explicit(&me->locked, memory_order_acquire)) {
+        CPU_PAUSE();
+    }
+}
+
+static inline void mcs_unlock(mcs_lock_t *lock, mcs_node_t *me) {
+    mcs_node_t *next = atomic_load_explicit(&me->next, memory_order_acquire);
+    if (next == NULL) {
+        mcs_node_t *expected = me;
+        if (atomic_compare_exchange_strong_explicit(
+                &lock->tail, &expected, NULL,
+                memory_order_release, memory_order_relaxed)) {
+            return;  // Nobody queued behind us
+        }
+        // A successor swapped tail but has not linked itself yet
+        while ((next = atomic_load_explicit(&me->next, memory_order_acquire)) == NULL) {
+            CPU_PAUSE();
+        }
+    }
+    atomic_store_explicit(&next->locked, false, memory_order_release);
+}
+
+/**
+ * Abortable CLH queue lock (Scott & Scherer "CLH-try", Herlihy & Shavit TOLock)
+ *
+ * Each waiter spins on its PREDECESSOR's node. A waiter that times out does
+ * not unlink itself (that would race with its neighbours); it just leaves a
+ * pointer to its own predecessor in its node, and whoever queues behind it
+ * skips over the abandoned node:
+ *
+ *   node->pred == NULL              owner is waiting or holding the lock
+ *   node->pred == TOQ_AVAILABLE     owner released the lock
+ *   node->pred == other node        owner gave up: wait on that node instead
+ *
+ * Node memory: a node is still read by its successor after its owner has
+ * left, so the owner may only reuse it once the successor marks it
+ * `reusable` (or no successor ever saw it). Each thread keeps its nodes in
+ * a toq_thread_t cache and allocates a new one only when all are in flight.
+ */
+typedef struct toq_node {
+    CACHE_ALIGNED _Atomic(struct toq_node *) pred;
+    atomic_bool reusable;
+    struct toq_node *next_owned;        // Owner's cache list
+} toq_node_t;
+
+typedef struct {
+    _Atomic(toq_node_t *) tail;
+} toq_lock_t;
+
+typedef struct {
+    toq_node_t *nodes;                  // Every node this thread allocated
+    toq_node_t *held;                   // Node that currently owns the lock
+    unsigned long allocated;
+} toq_thread_t;
+
+#define TOQ_LOCK_INITIALIZER { NULL }
+#define TOQ_THREAD_INITIALIZER { NULL, NULL, 0 }
+
+static toq_node_t toq_available_node;
+#define TOQ_AVAILABLE (&toq_available_node)
+
+static inline toq_node_t *toq_get_node(toq_thread_t *me) {
+    toq_node_t *n;
+    for (n = me->nodes; n != NULL; n = n->next_owned) {
+        if (atomic_load_explicit(&n->reusable, memory_order_acquire)) break;
+    }
+    if (n == NULL) {
+        n = cache_aligned_alloc(sizeof(*n));
+        n->next_owned = me->nodes;
+        me->nodes = n;
+        me->allocated++;
+    }
+    atomic_store_explicit(&n->pred, NULL, memory_order_relaxed);
+    atomic_store_explicit(&n->reusable, false, memory_order_relaxed);
+    return n;
+}
+
+/** Successor is done reading this node: its owner may recycle it */
+static inline void toq_release_node(toq_node_t *n) {
+    atomic_store_explicit(&n->reusable, true, memory_order_release);
+}
+
+static inline bool toq_lock_timeout(toq_lock_t *lock, toq_thread_t *me, uint64_t ns) {
+    toq_node_t *node = toq_get_node(me);
+    toq_node_t *pred = atomic_exchange_explicit(&lock->tail, node, memory_order_acq_rel);
+
+    if (pred == NULL) {
+        me->held = node;
+        return true;
+    }
+    uint64_t deadline = get_nanos() + ns;
+    while (1) {
+        toq_node_t *pp = atomic_load_explicit(&pred->pred, memory_order_acquire);
+        if (pp == TOQ_AVAILABLE) {
+            toq_release_node(pred);
+            me->held = node;
+            return true;
+        }
+        if (pp != NULL) {
+            toq_release_node(pred);     // Abandoned: skip to its predecessor
+            pred = pp;
+            continue;
+        }
+        if (get_nanos() >= deadline) break;
+        CPU_PAUSE();
+    }
+
+    // Timed out. If nobody queued behind us, roll the tail back and our node
+    // is free at once; otherwise point our successor at our predecessor.
+    toq_node_t *expected = node;
+    if (atomic_compare_exchange_strong_explicit(
+            &lock->tail, &expected, pred,
+            memory_order_release, memory_order_relaxed)) {
+        toq_release_node(node);
+    } else {
+        atomic_store_explicit(&node->pred, pred, memory_order_release);
+    }
+    return false;
+}
+
+static inline bool toq_trylock(toq_lock_t *lock, toq_thread_t *me) {
+    return toq_lock_timeout(lock, me, 0);
+}
+
+static inline void toq_unlock(toq_lock_t *lock, toq_thread_t *me) {
+    toq_node_t *node = me->held;
+    toq_node_t *expected = node;
+    me->held = NULL;
+    if (atomic_compare_exchange_strong_explicit(
+            &lock->tail, &expected, NULL,
+            memory_order_release, memory_order_relaxed)) {
+        toq_release_node(node);
+    } else {
+        atomic_store_explicit(&node->pred, TOQ_AVAILABLE, memory_order_release);
+    }
+}
+
+/**
+ * Free the thread's nodes. The lock's tail may still point at one of them
+ * (a released or abandoned node), so only call this once the lock itself is
+ * dead or about to be reset to TOQ_LOCK_INITIALIZER.
+ */
+static inline void toq_thread_destroy(toq_thread_t *me) {
+    while (me->nodes != NULL) {
+        toq_node_t *n = me->nodes;
+        me->nodes = n->next_owned;
+        free(n);
+    }
+}
+
+#endif // SPINLOCK_H
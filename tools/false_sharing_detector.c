@@ -0,0 +1,755 @@
+/**
+ * False-Sharing Detector
+ *
+ * Exercise 03 shows false sharing on counters we packed on purpose. In real
+ * code you find it by accident. This tool runs any program and samples the
+ * data addresses of its loads and stores with perf_event_open:
+ *
+ *   - Intel: PEBS events cpu/mem-stores/ and cpu/mem-loads/ (precise IP and
+ *     data address; mem-loads also reports HITM - the line was Modified in
+ *     another core's cache). Hybrid parts: cpu_core/ and cpu_atom/ together
+ *   - AMD:   IBS op sampling (ibs_op PMU)
+ *
+ * Samples are bucketed by CACHE_LINE_SIZE line. A line is reported when two
+ * or more threads touched it and at least one of them wrote it, together
+ * with each thread's byte offsets inside the line and the instruction that
+ * touched it (resolved with addr2line when available):
+ *
+ *   FALSE SHARING - the threads use disjoint offsets: pad them apart
+ *   true sharing  - threads hit the same offset (a lock, a shared counter)
+ *
+ * Usage:
+ *   false_sharing_detector [-c period] [-n top] program [args...]
+ *   make fsdetect-03      - Positive control: the packed counters are flagged,
+ *                           the cache-aligned ones are not
+ *
+ * Address sampling needs a hardware PMU: most VMs and containers do not
+ * expose PEBS/IBS, and perf_event_paranoid may forbid it. In that case the
+ * detector says why and runs the program unprofiled.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "benchmark.h"
+
+#ifdef __linux__
+
+#define DEFAULT_PERIOD 997       // Prime: avoids aliasing with loop strides
+#define DEFAULT_TOP 10
+#define RING_PAGES 32            // Data pages per ring (power of 2)
+#define MAX_EVENTS 2             // Stores + loads, each opened on every CPU
+#define LINE_TABLE_SIZE (1 << 16)
+#define MAX_LINE_THREADS 8       // Threads tracked per line
+#define MAX_MAPS 256
+#define POLL_MS 10
+
+#define SYSFS_PMU "/sys/bus/event_source/devices"
+
+// =============================================================================
+// Per-line statistics
+// =============================================================================
+
+typedef struct {
+    uint32_t tid;
+    uint64_t read_offsets;       // Bit i: a load started at byte i of the line
+    uint64_t write_offsets;      // Bit i: a store started at byte i
+    uint64_t untyped_offsets;    // Bit i: a load or a store, the PMU didn't say
+    uint64_t samples;
+    uint64_t ip;                 // First sampled instruction
+} line_thread_t;
+
+typedef struct {
+    uint64_t line;               // Line address; 0 = empty slot
+    uint64_t samples;
+    uint64_t stores;
+    uint64_t untyped;
+    uint64_t hitm;
+    int nthreads;
+    int overflow_threads;        // Threads beyond MAX_LINE_THREADS
+    line_thread_t threads[MAX_LINE_THREADS];
+} line_stat_t;
+
+static line_stat_t *lines;
+static long lines_used;
+static uint64_t samples_total, samples_dropped, samples_lost, samples_untyped;
+
+typedef enum { ACCESS_LOAD, ACCESS_STORE, ACCESS_UNTYPED } access_t;
+
+static line_stat_t *line_lookup(uint64_t line) {
+    uint64_t h = (line / CACHE_LINE_SIZE) * 0x9e3779b97f4a7c15ULL;
+    for (long i = 0; i < LINE_TABLE_SIZE; i++) {
+        line_stat_t *l = &lines[(h + i) & (LINE_TABLE_SIZE - 1)];
+        if (l->line == line) {
+            return l;
+        }
+        if (l->line == 0) {
+            if (lines_used >= LINE_TABLE_SIZE * 3 / 4) {
+                return NULL;     // Keep probes short: drop new lines when full
+            }
+            lines_used++;
+            l->line = line;
+            return l;
+        }
+    }
+    return NULL;
+}
+
+static void record_access(uint32_t tid, uint64_t addr, uint64_t ip, access_t access, bool hitm) {
+    line_stat_t *l = line_lookup(addr & ~(uint64_t)(CACHE_LINE_SIZE - 1));
+    if (!l) {
+        samples_dropped++;
+        return;
+    }
+    l->samples++;
+    l->stores += access == ACCESS_STORE;
+    l->untyped += access == ACCESS_UNTYPED;
+    l->hitm += hitm;
+
+    line_thread_t *t = NULL;
+    for (int i = 0; i < l->nthreads; i++) {
+        if (l->threads[i].tid == tid) {
+            t = &l->threads[i];
+            break;
+        }
+    }
+    if (!t) {
+        if (l->nthreads == MAX_LINE_THREADS) {
+            l->overflow_threads++;
+            return;
+        }
+        t = &l->threads[l->nthreads++];
+        t->tid = tid;
+        t->ip = ip;
+    }
+    uint64_t bit = 1ULL << (addr & (CACHE_LINE_SIZE - 1));
+    if (access == ACCESS_STORE) {
+        t->write_offsets |= bit;
+    } else if (access == ACCESS_UNTYPED) {
+        t->untyped_offsets |= bit;
+    } else {
+        t->read_offsets |= bit;
+    }
+    t->samples++;
+}
+
+// =============================================================================
+// Executable mappings (PERF_RECORD_MMAP) for symbolizing sampled IPs
+// =============================================================================
+
+typedef struct {
+    uint64_t start, len, pgoff;
+    char *file;
+} exec_map_t;
+
+static exec_map_t maps[MAX_MAPS];
+static int nmaps;
+
+static const exec_map_t *map_for(uint64_t ip) {
+    for (int i = nmaps - 1; i >= 0; i--) {
+        if (ip >= maps[i].start && ip - maps[i].start < maps[i].len) {
+            return &maps[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Describe ip as "function (file:line)" via addr2line, else "object+0xoff"
+ */
+static void describe_ip(uint64_t ip, char *out, size_t size) {
+    const exec_map_t *m = map_for(ip);
+    if (!m) {
+        snprintf(out, size, "0x%lx", (unsigned long)ip);
+        return;
+    }
+    uint64_t off = ip - m->start + m->pgoff;
+    const char *base = strrchr(m->file, '/') ? strrchr(m->file, '/') + 1 : m->file;
+    snprintf(out, size, "%s+0x%lx", base, (unsigned long)off);
+
+    char cmd[1024], func[192], where[192];
+    snprintf(cmd, sizeof(cmd), "addr2line -f -s -e '%s' 0x%lx 2>/dev/null", m->file,
+             (unsigned long)off);
+    FILE *p = popen(cmd, "r");
+    if (!p) {
+        return;
+    }
+    if (fgets(func, sizeof(func), p) && fgets(where, sizeof(where), p) && func[0] != '?') {
+        func[strcspn(func, "\n")] = '\0';
+        where[strcspn(where, "\n")] = '\0';
+        if (strncmp(where, "??", 2) == 0) {
+            snprintf(out, size, "%s", func);     // Built without -g
+        } else {
+            snprintf(out, size, "%s (%s)", func, where);
+        }
+    }
+    pclose(p);
+}
+
+// =============================================================================
+// Sampling events: sysfs PMU event strings -> perf_event_attr
+// =============================================================================
+
+typedef struct {
+    const char *name;            // For the report
+    const char *pmu;
+    int fd;
+    void *ring;                  // 1 metadata page + RING_PAGES data pages
+    size_t ring_size;
+    bool all_stores;             // Every sample of this event is a store
+} sampler_t;
+
+static sampler_t *samplers;      // MAX_EVENTS per CPU
+static int nsamplers, max_samplers;
+
+static bool read_sysfs(const char *path, char *buf, size_t size) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    bool ok = fgets(buf, (int)size, f) != NULL;
+    fclose(f);
+    buf[strcspn(buf, "\n")] = '\0';
+    return ok;
+}
+
+/**
+ * Set term `name` = value using the PMU's format file, e.g. "config:0-7" or
+ * "config1:0-15" or "config:0-7,32-35" (bits filled low to high)
+ */
+static bool set_format_term(struct perf_event_attr *attr, const char *pmu, const char *name,
+                            uint64_t value) {
+    char path[256], fmt[128];
+    snprintf(path, sizeof(path), SYSFS_PMU "/%s/format/%s", pmu, name);
+    if (!read_sysfs(path, fmt, sizeof(fmt))) {
+        return false;
+    }
+    char *colon = strchr(fmt, ':');
+    if (!colon) {
+        return false;
+    }
+    *colon = '\0';
+    __u64 *field = strcmp(fmt, "config") == 0  ? &attr->config
+                    : strcmp(fmt, "config1") == 0 ? &attr->config1
+                    : strcmp(fmt, "config2") == 0 ? &attr->config2
+                    : NULL;
+    if (!field) {
+        return false;
+    }
+    for (char *range = strtok(colon + 1, ","); range; range = strtok(NULL, ",")) {
+        int lo, hi;
+        int n = sscanf(range, "%d-%d", &lo, &hi);
+        if (n < 1) {
+            return false;
+        }
+        if (n == 1) {
+            hi = lo;
+        }
+        for (int bit = lo; bit <= hi; bit++, value >>= 1) {
+            *field |= (value & 1) << bit;
+        }
+    }
+    return true;
+}
+
+/**
+ * Fill attr from SYSFS_PMU/<pmu>/events/<event> ("event=0xcd,umask=0x1,ldlat=3")
+ */
+static bool parse_pmu_event(struct perf_event_attr *attr, const char *pmu, const char *event) {
+    char path[256], spec[256], type[32];
+    snprintf(path, sizeof(path), SYSFS_PMU "/%s/type", pmu);
+    if (!read_sysfs(path, type, sizeof(type))) {
+        return false;
+    }
+    attr->type = (uint32_t)strtoul(type, NULL, 10);
+    if (!event) {
+        return true;             // Whole-PMU event (ibs_op): config 0
+    }
+    snprintf(path, sizeof(path), SYSFS_PMU "/%s/events/%s", pmu, event);
+    if (!read_sysfs(path, spec, sizeof(spec))) {
+        return false;
+    }
+    char *save;
+    for (char *term = strtok_r(spec, ",", &save); term; term = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(term, '=');
+        uint64_t value = 1;
+        if (eq) {
+            *eq = '\0';
+            value = strtoull(eq + 1, NULL, 0);
+        }
+        if (!set_format_term(attr, pmu, term, value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * CPUs the PMU drives, from SYSFS_PMU/<pmu>/cpus ("0-15,24"). Hybrid Intel
+ * splits the core PMU into cpu_core (P-cores) and cpu_atom (E-cores), each
+ * listing its own CPUs; other PMUs have no such file and get every CPU
+ */
+static void pmu_cpus(const char *pmu, cpu_set_t *set) {
+    char path[256], list[1024];
+    CPU_ZERO(set);
+    snprintf(path, sizeof(path), SYSFS_PMU "/%s/cpus", pmu);
+    if (!read_sysfs(path, list, sizeof(list))) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, set);
+        }
+        return;
+    }
+    for (char *range = strtok(list, ","); range; range = strtok(NULL, ",")) {
+        int lo, hi;
+        int n = sscanf(range, "%d-%d", &lo, &hi);
+        if (n < 1) {
+            continue;
+        }
+        if (n == 1) {
+            hi = lo;
+        }
+        for (int cpu = lo; cpu <= hi && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, set);
+        }
+    }
+}
+
+static void close_samplers(int from) {
+    while (nsamplers > from) {
+        sampler_t *s = &samplers[--nsamplers];
+        munmap(s->ring, s->ring_size);
+        close(s->fd);
+    }
+}
+
+/**
+ * Open an event on the (stopped) child, once per CPU of the PMU: the kernel
+ * refuses to mmap an inherited per-task event, so like `perf record` we get
+ * one ring per CPU, shared by all the child's threads running there. CPUs
+ * that are offline or belong to another PMU are skipped; any other failure
+ * closes what was opened and returns false with errno set
+ */
+static bool open_sampler(const char *label, const char *pmu, const char *event, int precise,
+                         bool all_stores, pid_t child, uint64_t period) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    if (!parse_pmu_event(&attr, pmu, event)) {
+        errno = ENOENT;
+        return false;
+    }
+    attr.sample_period = period;
+    attr.sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_ADDR | PERF_SAMPLE_DATA_SRC;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;     // Skip our own fork/exec glue
+    attr.inherit = 1;            // Follow every thread the program creates
+    attr.mmap = 1;               // PERF_RECORD_MMAP for executable mappings
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.watermark = 1;
+    attr.wakeup_watermark = RING_PAGES * 4096 / 4;
+
+    int first = nsamplers;
+    bool negotiated = false;
+    long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+    int skipped = ENODEV;
+    cpu_set_t cpus;
+    pmu_cpus(pmu, &cpus);
+    for (int cpu = 0; cpu < ncpus && nsamplers < max_samplers; cpu++) {
+        if (cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &cpus)) {
+            continue;
+        }
+        int fd = -1;
+        if (!negotiated) {
+            // PEBS events need precise_ip >= 1; the supported maximum varies by model
+            for (int p = precise; p >= (precise > 0) && fd < 0; p--) {
+                attr.precise_ip = p;
+                fd = perf_event_open_attr(&attr, child, cpu);
+                if (fd < 0 && errno != EINVAL && errno != EOPNOTSUPP) {
+                    break;       // A lower precision will not help
+                }
+            }
+            if (fd < 0 && strcmp(pmu, "ibs_op") == 0 && errno == EINVAL) {
+                attr.exclude_kernel = 0; // Older IBS drivers reject exclude_*; filter ourselves
+                attr.exclude_hv = 0;
+                fd = perf_event_open_attr(&attr, child, cpu);
+            }
+        } else {
+            fd = perf_event_open_attr(&attr, child, cpu);
+        }
+        if (fd < 0 && (errno == ENODEV || errno == ENOENT)) {
+            skipped = errno;
+            continue;            // CPU offline, or driven by the other hybrid PMU
+        }
+        if (fd < 0) {
+            int saved = errno;
+            close_samplers(first);
+            errno = saved;
+            return false;
+        }
+        negotiated = true;
+
+        size_t size = (1 + RING_PAGES) * (size_t)sysconf(_SC_PAGESIZE);
+        void *ring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ring == MAP_FAILED) {
+            int saved = errno;   // EPERM: over perf_event_mlock_kb
+            close(fd);
+            close_samplers(first);
+            errno = saved;
+            return false;
+        }
+        samplers[nsamplers++] = (sampler_t){ label, pmu, fd, ring, size, all_stores };
+    }
+    if (!negotiated) {
+        errno = skipped;         // No CPU of this PMU took the event
+    }
+    return negotiated;
+}
+
+// =============================================================================
+// Ring buffer draining
+// =============================================================================
+
+struct sample_record {           // Layout for the sample_type set above
+    struct perf_event_header header;
+    uint64_t ip;
+    uint32_t pid, tid;
+    uint64_t addr;
+    uint64_t data_src;
+};
+
+struct mmap_record {
+    struct perf_event_header header;
+    uint32_t pid, tid;
+    uint64_t addr, len, pgoff;
+    char filename[];
+};
+
+static void handle_record(const sampler_t *s, const struct perf_event_header *h) {
+    if (h->type == PERF_RECORD_SAMPLE) {
+        const struct sample_record *r = (const void *)h;
+        samples_total++;
+        if ((h->misc & PERF_RECORD_MISC_CPUMODE_MASK) != PERF_RECORD_MISC_USER || r->addr == 0) {
+            return;              // Kernel sample (IBS), or an op without a data address
+        }
+        union perf_mem_data_src src = { .val = r->data_src };
+        bool store = s->all_stores || (src.mem_op & PERF_MEM_OP_STORE);
+        if (!store && !(src.mem_op & PERF_MEM_OP_LOAD) && src.val != 0) {
+            return;              // IBS: not a memory op
+        }
+        // Kernels before IBS data_src decoding (6.1) leave it 0: op unknown
+        access_t access = store                           ? ACCESS_STORE
+                          : src.mem_op & PERF_MEM_OP_LOAD ? ACCESS_LOAD
+                                                          : ACCESS_UNTYPED;
+        samples_untyped += access == ACCESS_UNTYPED;
+        bool hitm = (src.mem_snoop & PERF_MEM_SNOOP_HITM) != 0;
+        record_access(r->tid, r->addr, r->ip, access, hitm);
+    } else if (h->type == PERF_RECORD_MMAP && nmaps < MAX_MAPS) {
+        const struct mmap_record *m = (const void *)h;
+        maps[nmaps++] = (exec_map_t){ m->addr, m->len, m->pgoff, strdup(m->filename) };
+    } else if (h->type == PERF_RECORD_LOST) {
+        samples_lost += ((const uint64_t *)(h + 1))[1];
+    }
+}
+
+static void drain(sampler_t *s) {
+    struct perf_event_mmap_page *meta = s->ring;
+    char *data = (char *)s->ring + meta->data_offset;
+    uint64_t size = meta->data_size;
+    uint64_t head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+    uint64_t tail = meta->data_tail;
+    union {
+        struct perf_event_header header;
+        char bytes[4096 + 64];
+    } rec;
+
+    while (tail < head) {
+        const struct perf_event_header *h = (const void *)(data + tail % size);
+        size_t len = h->size;
+        if (len < sizeof(*h) || len > sizeof(rec)) {
+            break;               // Corrupt ring: give up on this batch
+        }
+        // Records may wrap around the end of the ring: copy them out first
+        size_t first = size - tail % size < len ? size - tail % size : len;
+        memcpy(rec.bytes, h, first);
+        memcpy(rec.bytes + first, data, len - first);
+        handle_record(s, &rec.header);
+        tail += len;
+    }
+    __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+}
+
+// =============================================================================
+// Report
+// =============================================================================
+
+static void format_offsets(uint64_t mask, char *out, size_t size) {
+    size_t n = 0;
+    out[0] = '\0';
+    for (int i = 0; i < CACHE_LINE_SIZE && n < size; i++) {
+        if (mask & (1ULL << i)) {
+            n += snprintf(out + n, size - n, "%s+%d", n ? "," : "", i);
+        }
+    }
+    if (!mask) {
+        snprintf(out, size, "-");
+    }
+}
+
+/**
+ * Two or more threads and a writer among them; an untyped sample may have
+ * been the write, so it counts as one
+ */
+static bool line_flagged(const line_stat_t *l) {
+    if (l->nthreads < 2) {
+        return false;
+    }
+    for (int i = 0; i < l->nthreads; i++) {
+        if (l->threads[i].write_offsets | l->threads[i].untyped_offsets) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t thread_offsets(const line_thread_t *t) {
+    return t->read_offsets | t->write_offsets | t->untyped_offsets;
+}
+
+/**
+ * False sharing when no two threads touched the same offset
+ */
+static bool line_false_sharing(const line_stat_t *l) {
+    for (int i = 0; i < l->nthreads; i++) {
+        uint64_t mine = thread_offsets(&l->threads[i]);
+        for (int j = i + 1; j < l->nthreads; j++) {
+            if (mine & thread_offsets(&l->threads[j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static int cmp_samples(const void *a, const void *b) {
+    const line_stat_t *x = *(line_stat_t *const *)a, *y = *(line_stat_t *const *)b;
+    return (x->samples < y->samples) - (x->samples > y->samples);
+}
+
+static void report(int top, uint64_t period) {
+    line_stat_t **flagged = malloc(sizeof(*flagged) * LINE_TABLE_SIZE);
+    long nflagged = 0, shared = 0;
+    for (long i = 0; i < LINE_TABLE_SIZE; i++) {
+        if (lines[i].line && lines[i].nthreads >= 2) {
+            shared++;
+        }
+        if (lines[i].line && line_flagged(&lines[i])) {
+            flagged[nflagged++] = &lines[i];
+        }
+    }
+    qsort(flagged, nflagged, sizeof(*flagged), cmp_samples);
+
+    printf("\n═══════════════════════════════════════════════════════════\n");
+    printf("  False-sharing report (%d-byte lines, 1 sample per %lu events)\n",
+           CACHE_LINE_SIZE, (unsigned long)period);
+    printf("  samples: %lu, lost: %lu, untracked: %lu, lines: %ld, shared: %ld, flagged: %ld\n",
+           (unsigned long)samples_total, (unsigned long)samples_lost,
+           (unsigned long)samples_dropped, lines_used, shared, nflagged);
+    if (samples_untyped) {
+        printf("  ⚠️  %lu samples came without a load/store type (IBS data_src\n",
+               (unsigned long)samples_untyped);
+        printf("     needs Linux 6.1+): loads and stores cannot be told apart, so an\n");
+        printf("     untyped sample (r/w) counts as a possible write\n");
+    }
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    if (nflagged == 0) {
+        printf("\n   No line was written by one thread and touched by another.\n");
+    }
+    for (long i = 0; i < nflagged && i < top; i++) {
+        const line_stat_t *l = flagged[i];
+        printf("\n   #%ld line 0x%lx  samples %lu  stores %lu  HITM %lu  %s\n", i + 1,
+               (unsigned long)l->line, (unsigned long)l->samples, (unsigned long)l->stores,
+               (unsigned long)l->hitm, line_false_sharing(l) ? "FALSE SHARING" : "true sharing");
+        for (int t = 0; t < l->nthreads; t++) {
+            const line_thread_t *th = &l->threads[t];
+            char writes[192], reads[192], untyped[192], where[512];
+            format_offsets(th->write_offsets, writes, sizeof(writes));
+            format_offsets(th->read_offsets, reads, sizeof(reads));
+            describe_ip(th->ip, where, sizeof(where));
+            printf("      tid %-7u writes %-12s reads %-12s", th->tid, writes, reads);
+            if (samples_untyped) {
+                format_offsets(th->untyped_offsets, untyped, sizeof(untyped));
+                printf(" r/w %-12s", untyped);
+            }
+            printf(" %7lu  %s\n", (unsigned long)th->samples, where);
+        }
+        if (l->overflow_threads) {
+            printf("      ... %d samples from further threads\n", l->overflow_threads);
+        }
+    }
+    if (nflagged > top) {
+        printf("\n   ... %ld more flagged lines (-n to show them)\n", nflagged - top);
+    }
+    printf("\n  FALSE SHARING: pad the fields apart (CACHE_ALIGNED / alignas(64)).\n");
+    printf("  true sharing:  the data itself is contended - shard or batch it.\n");
+    free(flagged);
+}
+
+// =============================================================================
+// Driver
+// =============================================================================
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-c period] [-n top] program [args...]\n", argv0);
+    exit(2);
+}
+
+static void explain_unavailable(int err) {
+    char paranoid[16] = "?";
+    read_sysfs("/proc/sys/kernel/perf_event_paranoid", paranoid, sizeof(paranoid));
+    fprintf(stderr, "false_sharing_detector: no data-address sampling on this host (%s).\n",
+            strerror(err));
+    fprintf(stderr, "  Needs PEBS (Intel cpu/mem-stores/, cpu/mem-loads/) or IBS (AMD ibs_op);\n");
+    fprintf(stderr, "  VMs rarely expose them. perf_event_paranoid = %s (needs <= 2).\n", paranoid);
+    fprintf(stderr, "  Running the program without profiling.\n\n");
+}
+
+int main(int argc, char **argv) {
+    uint64_t period = DEFAULT_PERIOD;
+    int top = DEFAULT_TOP;
+    int opt;
+    while ((opt = getopt(argc, argv, "+c:n:h")) != -1) {
+        switch (opt) {
+        case 'c': period = strtoull(optarg, NULL, 0); break;
+        case 'n': top = atoi(optarg); break;
+        default: usage(argv[0]);
+        }
+    }
+    if (optind >= argc || period == 0) {
+        usage(argv[0]);
+    }
+
+    // The child waits on `go` so its events exist before it execs
+    int go[2];
+    if (pipe(go) != 0) {
+        perror("pipe");
+        return 1;
+    }
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (child == 0) {
+        char c;
+        close(go[1]);
+        if (read(go[0], &c, 1) != 1) {
+            _exit(127);
+        }
+        close(go[0]);
+        execvp(argv[optind], &argv[optind]);
+        perror(argv[optind]);
+        _exit(127);
+    }
+    close(go[0]);
+
+    // Intel core PMUs first: "cpu", or on hybrid parts cpu_core + cpu_atom,
+    // which cover disjoint CPUs and are both opened. IBS only without them
+    long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+    max_samplers = MAX_EVENTS * ncpus;
+    samplers = calloc(max_samplers, sizeof(sampler_t));
+    int err = ENOENT;
+    const char *core_pmus[] = { "cpu", "cpu_core", "cpu_atom" };
+    for (int i = 0; i < 3; i++) {
+        if (open_sampler("mem-stores", core_pmus[i], "mem-stores", 3, true, child, period)) {
+            if (!open_sampler("mem-loads", core_pmus[i], "mem-loads", 3, false, child, period)) {
+                err = errno;
+            }
+        } else if (errno != ENOENT) {
+            err = errno;         // Keep the reason of a PMU that exists
+        }
+    }
+    if (nsamplers == 0 && !open_sampler("ibs_op", "ibs_op", NULL, 0, false, child,
+                                        (period + 15) & ~15ULL) && errno != ENOENT) {
+        err = errno;
+    }
+
+    bool profiling = nsamplers > 0;
+    if (profiling) {
+        lines = calloc(LINE_TABLE_SIZE, sizeof(line_stat_t));
+        fprintf(stderr, "false_sharing_detector: sampling");
+        for (int i = 0; i < nsamplers; i++) {
+            if (i == 0 || samplers[i].name != samplers[i - 1].name ||
+                samplers[i].pmu != samplers[i - 1].pmu) {
+                if (strcmp(samplers[i].name, samplers[i].pmu) == 0) {
+                    fprintf(stderr, " %s", samplers[i].name);
+                } else {
+                    fprintf(stderr, " %s/%s/", samplers[i].pmu, samplers[i].name);
+                }
+            }
+        }
+        fprintf(stderr, " every %lu events (%d rings)\n\n", (unsigned long)period, nsamplers);
+    } else {
+        explain_unavailable(err);
+    }
+
+    // Ctrl-C is for the program; we still want to print the report
+    signal(SIGINT, SIG_IGN);
+    if (write(go[1], "g", 1) != 1) {
+        perror("write");
+    }
+    close(go[1]);
+
+    struct pollfd *pfds = calloc(nsamplers + 1, sizeof(struct pollfd));
+    for (int i = 0; i < nsamplers; i++) {
+        pfds[i] = (struct pollfd){ .fd = samplers[i].fd, .events = POLLIN };
+    }
+    int status = 0;
+    for (;;) {
+        if (profiling) {
+            poll(pfds, nsamplers, POLL_MS);
+            for (int i = 0; i < nsamplers; i++) {
+                drain(&samplers[i]);
+            }
+        }
+        pid_t r = waitpid(child, &status, profiling ? WNOHANG : 0);
+        if (r == child || (r < 0 && errno != EINTR)) {
+            break;
+        }
+    }
+
+    if (profiling) {
+        for (int i = 0; i < nsamplers; i++) {
+            drain(&samplers[i]);
+        }
+        close_samplers(0);
+        report(top, period);
+        free(lines);
+    }
+    free(pfds);
+    free(samplers);
+    for (int i = 0; i < nmaps; i++) {
+        free(maps[i].file);
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+#else
+
+int main(void) {
+    fprintf(stderr, "false_sharing_detector: needs Linux perf_event_open\n");
+    return 1;
+}
+
+#endif // __linux__